@@ -0,0 +1,210 @@
+#pragma once
+
+// Finds the fastest backend, thread count, grain and schedule on this machine,
+// and keeps it in a config file, one line per machine
+//
+// A machine is the processor, the number of hardware threads, the compiler of the build
+// and the selected kernels, so a new build or a different box is tuned again. Each candidate renders a
+// few short scenes, the one with the least total of median times wins.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#include "RenderCore.h"
+#include "CpuInfo.h"
+
+// Without tabs, they separate the fields of the file
+inline std::string MachineFingerprint()
+{
+	std::string fingerprint = CpuModel() + ", " + std::to_string(std::thread::hardware_concurrency()) + " threads, " + buildCompilerString()
+		+ ", " + IsaName(SelectedIsa()) + " kernels";
+	std::replace(fingerprint.begin(), fingerprint.end(), '\t', ' ');
+	return fingerprint;
+}
+
+struct TuneChoice
+{
+	std::string backend;
+	int threads = 0;		// 0 for the default of the backend
+	int grain = 1;
+	RenderSchedule schedule = RenderSchedule::Dynamic;
+	double seconds = 0.0;	// Total of the median times of the scenes
+
+	std::string Describe() const
+	{
+		return backend + ", " + (threads ? std::to_string(threads) : std::string("default")) + " threads, grain "
+			+ std::to_string(grain) + ", " + ScheduleName(schedule) + " schedule";
+	}
+};
+
+class AutoTuner
+{
+public:
+	int width = 256, height = 192;
+	int repeat = 3;
+
+	// Called with each candidate, when measured
+	std::function<void(const TuneChoice& candidate)> progress;
+
+	std::vector<TuneChoice> Candidates() const
+	{
+		// All hardware threads, and half of them, for processors with two threads per core
+		const int hardware = int(std::max(1u, std::thread::hardware_concurrency()));
+		std::vector<int> threadCounts = { hardware };
+		if (hardware / 2 > 0)
+			threadCounts.push_back(hardware / 2);
+
+		std::vector<TuneChoice> candidates;
+		for (const auto& backend : RenderEngine::Backends())
+		{
+			TuneChoice c;
+			c.backend = backend.name;
+			if (!backend.threadControl)
+			{
+				candidates.push_back(c);
+				continue;
+			}
+
+			for (int threads : threadCounts)
+			{
+				for (int grain : { 1, 8 })
+				{
+					for (int schedule = 0; schedule < 3; schedule++)
+					{
+						c.threads = threads;
+						c.grain = grain;
+						c.schedule = RenderSchedule(schedule);
+						candidates.push_back(c);
+					}
+				}
+			}
+		}
+		return candidates;
+	}
+
+	TuneChoice Run()
+	{
+		struct Scene { double cx, cy, size; int iterations; };
+		static const Scene scenes[] =
+		{
+			{ -0.5, 0.0, 3.0, 256 },			// The whole set, mirrored, cheap outside and expensive inside
+			{ -0.7453, 0.1127, 6.5e-4, 512 },	// Seahorse valley, no symmetry, unevenly spread cost
+		};
+
+		std::vector<int> values(size_t(width) * height);
+		RenderTarget target;
+		target.values = values.data();
+
+		TuneChoice best;
+		for (TuneChoice c : Candidates())
+		{
+			RenderSettings settings;
+			settings.backend = size_t(RenderEngine::FindBackend(c.backend));
+			settings.threads = c.threads;
+			settings.grain = c.grain;
+			settings.schedule = c.schedule;
+
+			c.seconds = 0.0;
+			for (const Scene& scene : scenes)
+			{
+				FormulaDefaults defaults;
+				std::unique_ptr<IComputePoint> point(CreateComputePoint("plain"));
+				point->z.reset(CreateComputeState("mandelbrot", defaults));
+				point->maxIterations = scene.iterations;
+				point->bailOutSquare = defaults.bailoutSquare;
+				const RenderView view = CenteredView(width, height, scene.cx, scene.cy, scene.size);
+
+				// One run to warm up the thread pools and caches
+				std::vector<double> times;
+				for (int i = 0; i <= repeat; i++)
+				{
+					auto tp1 = std::chrono::high_resolution_clock::now();
+					RenderEngine(view, settings, *point, target).Render();
+					std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - tp1;
+					if (i > 0)
+						times.push_back(elapsed.count());
+				}
+				c.seconds += NearestRankPercentile(times, 0.5);
+			}
+
+			if (progress)
+				progress(c);
+			if (best.backend.empty() || c.seconds < best.seconds)
+				best = c;
+		}
+
+		return best;
+	}
+};
+
+// The tuned choices of all machines, a line each: fingerprint, backend, threads, grain and schedule,
+// separated by tabs
+class TuneFile
+{
+public:
+	explicit TuneFile(const std::string& path_) : path(path_) {}
+
+	// The choice of the machine, false when it isn't tuned, or the backend is not in this build
+	bool Load(const std::string& fingerprint, TuneChoice& choice) const
+	{
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::vector<std::string> fields = Split(line);
+			TuneChoice c;
+			if (fields.size() != 5 || fields[0] != fingerprint || RenderEngine::FindBackend(fields[1]) < 0
+				|| !FindSchedule(fields[4], c.schedule))
+				continue;
+
+			c.backend = fields[1];
+			c.threads = std::max(0, std::atoi(fields[2].c_str()));
+			c.grain = std::max(1, std::atoi(fields[3].c_str()));
+			choice = c;
+			return true;
+		}
+		return false;
+	}
+
+	// Replaces the line of the machine, keeping the others
+	bool Save(const std::string& fingerprint, const TuneChoice& choice) const
+	{
+		std::vector<std::string> lines;
+		{
+			std::ifstream file(path);
+			std::string line;
+			while (std::getline(file, line))
+			{
+				std::vector<std::string> fields = Split(line);
+				if (!line.empty() && (fields.empty() || fields[0] != fingerprint))
+					lines.push_back(line);
+			}
+		}
+		lines.push_back(fingerprint + "\t" + choice.backend + "\t" + std::to_string(choice.threads) + "\t"
+						+ std::to_string(choice.grain) + "\t" + ScheduleName(choice.schedule));
+
+		std::ofstream file(path, std::ios::trunc);
+		for (const auto& line : lines)
+			file << line << "\n";
+		return bool(file);
+	}
+
+private:
+	static std::vector<std::string> Split(const std::string& line)
+	{
+		std::vector<std::string> fields;
+		std::istringstream stream(line);
+		std::string field;
+		while (std::getline(stream, field, '\t'))
+			fields.push_back(field);
+		return fields;
+	}
+
+	std::string path;
+};
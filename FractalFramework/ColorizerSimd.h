@@ -0,0 +1,79 @@
+#pragma once
+#include "olcPixelGameEngine.h"
+
+// SSE2 helpers for the span versions of the colorizers
+// Without SSE2 the colorizers use their per pixel functions for spans
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLORIZER_SIMD 1
+#include <emmintrin.h>
+
+namespace ColorizerSimd
+{
+	inline __m128 Load(const int* values)
+	{
+		return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)values));
+	}
+
+	inline __m128 Load(const float* values)
+	{
+		return _mm_loadu_ps(values);
+	}
+
+	// Integer part, rounded towards zero
+	inline __m128 Truncate(__m128 x)
+	{
+		return _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	}
+
+	// Polynomial sine, within a few float ulps of std::sin for the angles used by the colorizers
+	inline __m128 Sin(__m128 x)
+	{
+		// Reduce to [-pi, pi], 2 pi split in two parts to keep the precision
+		const __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.159154943f))));
+		x = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(6.28125f)));
+		x = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(1.93530717958e-3f)));
+
+		// Fold to [-pi/2, pi/2] with sin(x) = sin(pi - x)
+		const __m128 pi = _mm_set1_ps(3.14159265f);
+		x = _mm_min_ps(x, _mm_sub_ps(pi, x));
+		x = _mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(pi, x)));
+
+		// Taylor series to x^11
+		const __m128 x2 = _mm_mul_ps(x, x);
+		__m128 p = _mm_set1_ps(-2.50521084e-8f);
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(2.75573192e-6f));
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.98412698e-4f));
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(8.33333333e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.66666667e-1f));
+		p = _mm_mul_ps(p, x2);
+		return _mm_add_ps(x, _mm_mul_ps(p, x));
+	}
+
+	// Channels from 0 to 255 into four opaque pixels
+	inline void StorePixels(olc::Pixel* out, __m128i r, __m128i g, __m128i b)
+	{
+		const __m128i mask = _mm_set1_epi32(0xFF);
+		__m128i n = _mm_and_si128(r, mask);
+		n = _mm_or_si128(n, _mm_slli_epi32(_mm_and_si128(g, mask), 8));
+		n = _mm_or_si128(n, _mm_slli_epi32(_mm_and_si128(b, mask), 16));
+		n = _mm_or_si128(n, _mm_set1_epi32(int(0xFF000000u)));
+		_mm_storeu_si128((__m128i*)out, n);
+	}
+
+	// Channels from 0.0 to 1.0 into four pixels, as olc::PixelF
+	inline void StorePixelF(olc::Pixel* out, __m128 r, __m128 g, __m128 b)
+	{
+		const __m128 full = _mm_set1_ps(255.0f);
+		__m128i ir = _mm_cvttps_epi32(_mm_mul_ps(r, full));
+		__m128i ig = _mm_cvttps_epi32(_mm_mul_ps(g, full));
+		__m128i ib = _mm_cvttps_epi32(_mm_mul_ps(b, full));
+		StorePixels(out, ir, ig, ib);
+	}
+
+	// Select a where mask is set, otherwise b
+	inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+}
+#endif
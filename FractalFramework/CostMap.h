@@ -0,0 +1,194 @@
+#pragma once
+
+// Where the time of a render goes: wall time and iterations per tile of the view,
+// and busy time per thread
+//
+// The render engine adds the cost of every span of a row it calculates to the tile the
+// span lies in, from any thread. Mirrored and disk filled pixels cost nothing, so the
+// map also shows where those pay off. Iterations are the nominal ones, from the counts:
+// pixels at the limit count as the full limit, even if loop detection stopped them early.
+// The busy time of the threads, compared to the wall time, shows how well the work was balanced.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+class CostMap
+{
+public:
+	static const int tileSize = 32;		// Pixels, in both directions
+
+	void Reset(int width_, int height_)
+	{
+		if (!tiles || width_ != width || height_ != height)
+		{
+			width = width_;
+			height = height_;
+			columns = (width + tileSize - 1) / tileSize;
+			rows = (height + tileSize - 1) / tileSize;
+			tiles.reset(new Tile[size_t(columns) * rows]);
+		}
+		else
+		{
+			for (int i = 0; i < columns * rows; i++)
+				tiles[i].nanoseconds = tiles[i].iterations = 0;
+		}
+		totalNanoseconds = 0;
+	}
+
+	// Cost of a span of a row, the span must not cross a tile boundary
+	void Add(int x, int y, uint64_t nanoseconds, uint64_t iterations)
+	{
+		if (!tiles || x < 0 || x >= width || y < 0 || y >= height)
+			return;
+
+		Tile& tile = tiles[size_t(y / tileSize) * columns + x / tileSize];
+		tile.nanoseconds += nanoseconds;
+		tile.iterations += iterations;
+		totalNanoseconds += nanoseconds;
+	}
+
+	int Width() const { return width; }
+	int Height() const { return height; }
+	int Columns() const { return columns; }
+	int Rows() const { return rows; }
+
+	uint64_t Nanoseconds(int column, int row) const { return tiles[size_t(row) * columns + column].nanoseconds; }
+	uint64_t Iterations(int column, int row) const { return tiles[size_t(row) * columns + column].iterations; }
+
+	// Changes whenever a cost is added, to see if the map must be drawn again
+	uint64_t TotalNanoseconds() const { return totalNanoseconds; }
+
+	uint64_t MaxNanoseconds() const
+	{
+		uint64_t m = 0;
+		for (int i = 0; i < columns * rows; i++)
+			m = std::max(m, uint64_t(tiles[i].nanoseconds));
+		return m;
+	}
+
+	// One line per tile, with its pixel rectangle
+	bool WriteCsv(const std::string& path) const
+	{
+		FILE* file = std::fopen(path.c_str(), "w");
+		if (!file)
+			return false;
+
+		std::fprintf(file, "column,row,x,y,width,height,microseconds,iterations,ns_per_pixel,iterations_per_pixel\n");
+		for (int r = 0; r < rows; r++)
+		{
+			for (int c = 0; c < columns; c++)
+			{
+				const int x = c * tileSize, y = r * tileSize;
+				const int w = std::min(tileSize, width - x), h = std::min(tileSize, height - y);
+				const double pixels = double(w) * h;
+				const uint64_t ns = Nanoseconds(c, r), its = Iterations(c, r);
+
+				std::fprintf(file, "%d,%d,%d,%d,%d,%d,%.3f,%llu,%.2f,%.2f\n", c, r, x, y, w, h,
+							 ns / 1000.0, (unsigned long long)its, ns / pixels, its / pixels);
+			}
+		}
+
+		return std::fclose(file) == 0;
+	}
+
+private:
+	struct Tile
+	{
+		std::atomic<uint64_t> nanoseconds{ 0 };
+		std::atomic<uint64_t> iterations{ 0 };
+	};
+
+	int width = 0, height = 0;
+	int columns = 0, rows = 0;
+	std::unique_ptr<Tile[]> tiles;
+	std::atomic<uint64_t> totalNanoseconds{ 0 };
+};
+
+// Busy time of every thread that worked on a render, in the order they started working
+class WorkerLoad
+{
+public:
+	static const int maxWorkers = 256;	// Threads beyond these are not recorded
+
+	WorkerLoad()
+	{
+		for (int i = 0; i < maxWorkers; i++)
+		{
+			ids[i] = std::thread::id();
+			busy[i] = 0;
+		}
+	}
+
+	void Reset()
+	{
+		const int n = std::min(int(workers), maxWorkers);
+		for (int i = 0; i < n; i++)
+		{
+			ids[i] = std::thread::id();
+			busy[i] = 0;
+		}
+		workers = 0;
+	}
+
+	void Add(uint64_t nanoseconds)
+	{
+		const std::thread::id me = std::this_thread::get_id();
+		const int n = std::min(int(workers), maxWorkers);
+
+		for (int i = 0; i < n; i++)
+		{
+			if (ids[i].load(std::memory_order_relaxed) == me)
+			{
+				busy[i] += nanoseconds;
+				return;
+			}
+		}
+
+		// Only this thread claims a slot for itself, others don't match it until it is set
+		const int slot = workers++;
+		if (slot >= maxWorkers)
+			return;
+		busy[slot] = nanoseconds;
+		ids[slot] = me;
+	}
+
+	int Workers() const { return std::min(int(workers), maxWorkers); }
+	uint64_t Busy(int worker) const { return busy[worker]; }
+
+private:
+	std::atomic<std::thread::id> ids[maxWorkers];
+	std::atomic<uint64_t> busy[maxWorkers];
+	std::atomic<int> workers{ 0 };
+};
+
+// Busy time of the calling thread from construction to destruction, added to the load
+// Does nothing without a load
+class WorkerScope
+{
+public:
+	WorkerScope(WorkerLoad* load_) : load(load_)
+	{
+		if (load)
+			start = std::chrono::steady_clock::now();
+	}
+
+	~WorkerScope()
+	{
+		if (load)
+			load->Add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+	}
+
+	WorkerScope(const WorkerScope&) = delete;
+	WorkerScope& operator=(const WorkerScope&) = delete;
+
+private:
+	WorkerLoad* load;
+	std::chrono::steady_clock::time_point start;
+};
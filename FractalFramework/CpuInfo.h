@@ -0,0 +1,67 @@
+#pragma once
+
+// What the processor is, for telling machines apart
+
+#include <string>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#elif defined(__linux__)
+#include <fstream>
+#endif
+
+// The brand string of the processor, "unknown" where it can't be found
+inline std::string CpuModel()
+{
+	std::string model;
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int regs[4] = {};
+	__cpuid(regs, 0x80000000);
+	if (unsigned(regs[0]) >= 0x80000004)
+	{
+		char brand[49] = {};
+		for (int i = 0; i < 3; i++)
+		{
+			__cpuid(regs, 0x80000002 + i);
+			std::memcpy(brand + 16 * i, regs, sizeof(regs));
+		}
+		model = brand;
+	}
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	unsigned int regs[4] = {};
+	if (__get_cpuid(0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]) && regs[0] >= 0x80000004)
+	{
+		char brand[49] = {};
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			__get_cpuid(0x80000002 + i, &regs[0], &regs[1], &regs[2], &regs[3]);
+			std::memcpy(brand + 16 * i, regs, sizeof(regs));
+		}
+		model = brand;
+	}
+#elif defined(__linux__)
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	std::string line;
+	while (model.empty() && std::getline(cpuinfo, line))
+	{
+		// "model name" on most, "Model" on some ARM boards
+		if (line.compare(0, 10, "model name") == 0 || line.compare(0, 5, "Model") == 0)
+		{
+			size_t colon = line.find(':');
+			if (colon != std::string::npos)
+				model = line.substr(colon + 1);
+		}
+	}
+#endif
+
+	// Brand strings are padded with spaces
+	const size_t first = model.find_first_not_of(' ');
+	const size_t last = model.find_last_not_of(' ');
+	if (first == std::string::npos)
+		return "unknown";
+	return model.substr(first, last - first + 1);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "IColorizer.h"
+#include "ColorizerSimd.h"
 #include <cmath>
 
 class ErikssonColorizer : public Colorizer
@@ -26,7 +27,37 @@ public:
 		return olc::PixelF(0.5f * std::sin(scaledAngle) + 0.5f, 0.5f * sin(scaledAngle + 2*pithird) + 0.5f, 0.5f * sin(scaledAngle + 4*pithird) + 0.5f);
 	}
 
+#if defined(COLORIZER_SIMD)
+	void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override { Span(values, out, n); }
+	void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override { Span(values, out, n); }
+#endif
+
 private:
+#if defined(COLORIZER_SIMD)
+	template <typename T>
+	void Span(const T* values, olc::Pixel* out, size_t n) const
+	{
+		using namespace ColorizerSimd;
+
+		const __m128 twoPi = _mm_set1_ps(2 * pi);
+		const __m128 scale = _mm_set1_ps(getScale());
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 third = _mm_set1_ps(2 * pithird);
+		const __m128 twoThirds = _mm_set1_ps(4 * pithird);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 angle = _mm_div_ps(_mm_mul_ps(twoPi, Load(values + i)), scale);
+			__m128 r = _mm_add_ps(_mm_mul_ps(half, Sin(angle)), half);
+			__m128 g = _mm_add_ps(_mm_mul_ps(half, Sin(_mm_add_ps(angle, third))), half);
+			__m128 b = _mm_add_ps(_mm_mul_ps(half, Sin(_mm_add_ps(angle, twoThirds))), half);
+			StorePixelF(out + i, r, g, b);
+		}
+		for (; i < n; i++)
+			out[i] = ColorizePixel(values[i]);
+	}
+#endif
 };
 
 // const float ErikssonColorizer::pi = 3.141593f;
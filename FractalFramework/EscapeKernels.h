@@ -0,0 +1,302 @@
+#pragma once
+
+// Escape counts of several points at once, in the vector instructions of the processor
+//
+// The kernels are built for SSE2, AVX2 with FMA and AVX-512 in the same binary, and the best
+// one the processor supports is selected at startup. FRACTAL_ISA=scalar|sse2|avx2|avx512 in
+// the environment selects a lower one, for testing. They calculate the Mandelbrot formula
+// for ComputePoint exactly as MandelComputeState does, lane by lane, with the multiplications
+// and additions kept apart, so the counts are the same, bit for bit. Fused multiply-add
+// would round differently, so it is not used, even where it is available.
+
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ESCAPE_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Functions built for an instruction set, other than the one of the build
+// Contraction to fused multiply-add is switched off for GCC, it would change the results
+#if defined(__clang__)
+#define ESCAPE_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__GNUC__)
+#define ESCAPE_KERNEL_TARGET(isa) __attribute__((target(isa), optimize("fp-contract=off")))
+#else
+#define ESCAPE_KERNEL_TARGET(isa)
+#endif
+
+enum class KernelIsa
+{
+	Scalar,		// The ComputePoint classes, no kernel
+	Sse2,		// 2 points at once
+	Avx2,		// 4 points, on processors with AVX2 and FMA
+	Avx512		// 8 points, with AVX-512F
+};
+
+inline const char* IsaName(KernelIsa isa)
+{
+	static const char* names[] = { "scalar", "sse2", "avx2", "avx512" };
+	return names[int(isa)];
+}
+
+inline bool IsaSupported(KernelIsa isa)
+{
+	if (isa == KernelIsa::Scalar)
+		return true;
+
+#if defined(ESCAPE_KERNELS_X86) && defined(__GNUC__)
+	// Checks the support of the operating system for the wider registers as well
+	__builtin_cpu_init();
+	switch (isa)
+	{
+	case KernelIsa::Sse2:
+		return __builtin_cpu_supports("sse2");
+	case KernelIsa::Avx2:
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case KernelIsa::Avx512:
+		return __builtin_cpu_supports("avx512f");
+	default:
+		return false;
+	}
+#elif defined(ESCAPE_KERNELS_X86) && defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0);
+	const int maxLeaf = regs[0];
+	__cpuid(regs, 1);
+	const bool sse2 = (regs[3] & (1 << 26)) != 0;
+	const bool fma = (regs[2] & (1 << 12)) != 0;
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+
+	// The operating system must save the wider registers: XMM and YMM, and for AVX-512 the masks and ZMM
+	const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool avxState = (xcr0 & 0x6) == 0x6;
+	const bool avx512State = (xcr0 & 0xE6) == 0xE6;
+
+	bool avx2 = false, avx512f = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(regs, 7, 0);
+		avx2 = (regs[1] & (1 << 5)) != 0;
+		avx512f = (regs[1] & (1 << 16)) != 0;
+	}
+
+	switch (isa)
+	{
+	case KernelIsa::Sse2:
+		return sse2;
+	case KernelIsa::Avx2:
+		return avx2 && fma && avxState;
+	case KernelIsa::Avx512:
+		return avx512f && avx512State;
+	default:
+		return false;
+	}
+#else
+	return false;
+#endif
+}
+
+// The best supported instruction set, or the one in FRACTAL_ISA when lower, decided once
+inline KernelIsa SelectedIsa()
+{
+	static const KernelIsa selected = []
+		{
+			int limit = int(KernelIsa::Avx512);
+			if (const char* requested = std::getenv("FRACTAL_ISA"))
+			{
+				for (int i = 0; i <= int(KernelIsa::Avx512); i++)
+				{
+					if (std::string(requested) == IsaName(KernelIsa(i)))
+						limit = i;
+				}
+			}
+
+			int isa = limit;
+			while (isa > 0 && !IsaSupported(KernelIsa(isa)))
+				isa--;
+			return KernelIsa(isa);
+		}();
+	return selected;
+}
+
+// What the kernels calculate: for the Mandelbrot set c is the point and z starts at z0,
+// for julia sets c is the seed and z starts at the point
+struct EscapeKernelParams
+{
+	bool julia = false;
+	double seedr = 0.0, seedi = 0.0;
+	double z0r = 0.0, z0i = 0.0;
+	double bailOutSquare = 4.0;
+	int maxIterations = 256;
+};
+
+// Escape counts of n points of a row, at xs and y
+using EscapeKernel = void (*)(const double* xs, int n, double y, const EscapeKernelParams& p, int* counts);
+
+#if defined(ESCAPE_KERNELS_X86)
+
+// Lanes past the end of the points repeat the last one
+ESCAPE_KERNEL_TARGET("sse2")
+inline void EscapeCountsSse2(const double* xs, int n, double y, const EscapeKernelParams& p, int* counts)
+{
+	const __m128d bail = _mm_set1_pd(p.bailOutSquare);
+	const __m128d maxCount = _mm_set1_pd(double(p.maxIterations));
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d two = _mm_set1_pd(2.0);
+
+	for (int i = 0; i < n; i += 2)
+	{
+		const __m128d x = _mm_set_pd(xs[std::min(i + 1, n - 1)], xs[i]);
+		const __m128d cr = p.julia ? _mm_set1_pd(p.seedr) : x;
+		const __m128d ci = p.julia ? _mm_set1_pd(p.seedi) : _mm_set1_pd(y);
+		__m128d zr = p.julia ? x : _mm_set1_pd(p.z0r);
+		__m128d zi = p.julia ? _mm_set1_pd(y) : _mm_set1_pd(p.z0i);
+		__m128d zr2 = _mm_mul_pd(zr, zr);
+		__m128d zi2 = _mm_mul_pd(zi, zi);
+		__m128d count = _mm_setzero_pd();
+
+		for (;;)
+		{
+			const __m128d active = _mm_and_pd(_mm_cmplt_pd(_mm_add_pd(zr2, zi2), bail), _mm_cmplt_pd(count, maxCount));
+			if (!_mm_movemask_pd(active))
+				break;
+
+			// zi = zr * zi * 2.0 + ci, zr = zr2 - zi2 + cr, for the active lanes
+			__m128d t = _mm_mul_pd(zr, zi);
+			t = _mm_mul_pd(t, two);
+			const __m128d nzi = _mm_add_pd(t, ci);
+			const __m128d nzr = _mm_add_pd(_mm_sub_pd(zr2, zi2), cr);
+			zi = _mm_or_pd(_mm_and_pd(active, nzi), _mm_andnot_pd(active, zi));
+			zr = _mm_or_pd(_mm_and_pd(active, nzr), _mm_andnot_pd(active, zr));
+
+			zr2 = _mm_mul_pd(zr, zr);
+			zi2 = _mm_mul_pd(zi, zi);
+			count = _mm_add_pd(count, _mm_and_pd(active, one));
+		}
+
+		double c[2];
+		_mm_storeu_pd(c, count);
+		for (int k = 0; k < 2 && i + k < n; k++)
+			counts[i + k] = int(c[k]);
+	}
+}
+
+ESCAPE_KERNEL_TARGET("avx2,fma")
+inline void EscapeCountsAvx2(const double* xs, int n, double y, const EscapeKernelParams& p, int* counts)
+{
+	const __m256d bail = _mm256_set1_pd(p.bailOutSquare);
+	const __m256d maxCount = _mm256_set1_pd(double(p.maxIterations));
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d two = _mm256_set1_pd(2.0);
+
+	for (int i = 0; i < n; i += 4)
+	{
+		const __m256d x = _mm256_set_pd(xs[std::min(i + 3, n - 1)], xs[std::min(i + 2, n - 1)], xs[std::min(i + 1, n - 1)], xs[i]);
+		const __m256d cr = p.julia ? _mm256_set1_pd(p.seedr) : x;
+		const __m256d ci = p.julia ? _mm256_set1_pd(p.seedi) : _mm256_set1_pd(y);
+		__m256d zr = p.julia ? x : _mm256_set1_pd(p.z0r);
+		__m256d zi = p.julia ? _mm256_set1_pd(y) : _mm256_set1_pd(p.z0i);
+		__m256d zr2 = _mm256_mul_pd(zr, zr);
+		__m256d zi2 = _mm256_mul_pd(zi, zi);
+		__m256d count = _mm256_setzero_pd();
+
+		for (;;)
+		{
+			const __m256d active = _mm256_and_pd(_mm256_cmp_pd(_mm256_add_pd(zr2, zi2), bail, _CMP_LT_OQ),
+												 _mm256_cmp_pd(count, maxCount, _CMP_LT_OQ));
+			if (!_mm256_movemask_pd(active))
+				break;
+
+			__m256d t = _mm256_mul_pd(zr, zi);
+			t = _mm256_mul_pd(t, two);
+			const __m256d nzi = _mm256_add_pd(t, ci);
+			const __m256d nzr = _mm256_add_pd(_mm256_sub_pd(zr2, zi2), cr);
+			zi = _mm256_blendv_pd(zi, nzi, active);
+			zr = _mm256_blendv_pd(zr, nzr, active);
+
+			zr2 = _mm256_mul_pd(zr, zr);
+			zi2 = _mm256_mul_pd(zi, zi);
+			count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+		}
+
+		double c[4];
+		_mm256_storeu_pd(c, count);
+		for (int k = 0; k < 4 && i + k < n; k++)
+			counts[i + k] = int(c[k]);
+	}
+}
+
+ESCAPE_KERNEL_TARGET("avx512f")
+inline void EscapeCountsAvx512(const double* xs, int n, double y, const EscapeKernelParams& p, int* counts)
+{
+	const __m512d bail = _mm512_set1_pd(p.bailOutSquare);
+	const __m512d maxCount = _mm512_set1_pd(double(p.maxIterations));
+	const __m512d one = _mm512_set1_pd(1.0);
+	const __m512d two = _mm512_set1_pd(2.0);
+
+	for (int i = 0; i < n; i += 8)
+	{
+		double lanes[8];
+		for (int k = 0; k < 8; k++)
+			lanes[k] = xs[std::min(i + k, n - 1)];
+		const __m512d x = _mm512_loadu_pd(lanes);
+		const __m512d cr = p.julia ? _mm512_set1_pd(p.seedr) : x;
+		const __m512d ci = p.julia ? _mm512_set1_pd(p.seedi) : _mm512_set1_pd(y);
+		__m512d zr = p.julia ? x : _mm512_set1_pd(p.z0r);
+		__m512d zi = p.julia ? _mm512_set1_pd(y) : _mm512_set1_pd(p.z0i);
+		__m512d zr2 = _mm512_mul_pd(zr, zr);
+		__m512d zi2 = _mm512_mul_pd(zi, zi);
+		__m512d count = _mm512_setzero_pd();
+
+		for (;;)
+		{
+			const __mmask8 active = _mm512_cmp_pd_mask(_mm512_add_pd(zr2, zi2), bail, _CMP_LT_OQ)
+				& _mm512_cmp_pd_mask(count, maxCount, _CMP_LT_OQ);
+			if (!active)
+				break;
+
+			__m512d t = _mm512_mul_pd(zr, zi);
+			t = _mm512_mul_pd(t, two);
+			const __m512d nzi = _mm512_add_pd(t, ci);
+			const __m512d nzr = _mm512_add_pd(_mm512_sub_pd(zr2, zi2), cr);
+			zi = _mm512_mask_mov_pd(zi, active, nzi);
+			zr = _mm512_mask_mov_pd(zr, active, nzr);
+
+			zr2 = _mm512_mul_pd(zr, zr);
+			zi2 = _mm512_mul_pd(zi, zi);
+			count = _mm512_mask_add_pd(count, active, count, one);
+		}
+
+		double c[8];
+		_mm512_storeu_pd(c, count);
+		for (int k = 0; k < 8 && i + k < n; k++)
+			counts[i + k] = int(c[k]);
+	}
+}
+
+#endif
+
+// The kernel of the selected instruction set, nullptr for scalar
+inline EscapeKernel SelectedEscapeKernel()
+{
+#if defined(ESCAPE_KERNELS_X86)
+	switch (SelectedIsa())
+	{
+	case KernelIsa::Sse2:
+		return &EscapeCountsSse2;
+	case KernelIsa::Avx2:
+		return &EscapeCountsAvx2;
+	case KernelIsa::Avx512:
+		return &EscapeCountsAvx512;
+	default:
+		break;
+	}
+#endif
+	return nullptr;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Statistics of the escape counts of a calculated view,
+// used to propose the iteration limit and the color scale
+struct EscapeStatistics
+{
+	int maxIterations = 0;
+	uint64_t pixels = 0;
+	uint64_t escaped = 0;
+	uint64_t interior = 0;		// At the limit, inside or not resolved yet
+	uint64_t nearLimit = 0;		// Escaped in the last quarter below the limit
+
+	// Escape counts below which 50%, 99% and 99.9% of the escaped pixels are
+	int p50 = 0, p99 = 0, p999 = 0;
+
+	double InteriorFraction() const { return pixels ? double(interior) / pixels : 0.0; }
+
+	// Pixels escaping this close to the limit, suggest that some of the interior
+	// pixels would escape with more iterations
+	double UnresolvedFraction() const { return escaped ? double(nearLimit) / escaped : 0.0; }
+
+	void Gather(const int* values, size_t n, int maxIterations_)
+	{
+		maxIterations = maxIterations_;
+		std::vector<uint64_t> histogram(maxIterations, 0);
+		uint64_t inside = 0;
+
+		const int chunk = 4096;
+		const int chunks = int((n + chunk - 1) / chunk);
+
+#pragma omp parallel reduction(+ : inside)
+		{
+			std::vector<uint64_t> local(maxIterations, 0);
+
+			int c;
+#pragma omp for schedule(static) nowait
+			for (c = 0; c < chunks; c++)
+			{
+				const size_t end = std::min(n, size_t(c + 1) * chunk);
+				for (size_t i = size_t(c) * chunk; i < end; i++)
+				{
+					if ((unsigned)values[i] < (unsigned)maxIterations)
+						local[values[i]]++;
+					else
+						inside++;
+				}
+			}
+
+#pragma omp critical
+			for (int i = 0; i < maxIterations; i++)
+				histogram[i] += local[i];
+		}
+
+		pixels = n;
+		interior = inside;
+		escaped = n - inside;
+
+		nearLimit = 0;
+		for (int i = maxIterations - maxIterations / 4; i < maxIterations; i++)
+			nearLimit += histogram[i];
+
+		// Percentiles from the cumulative counts
+		p50 = p99 = p999 = 0;
+		uint64_t sum = 0;
+		for (int i = 0; i < maxIterations; i++)
+		{
+			sum += histogram[i];
+			if (sum * 2 < escaped)
+				p50 = i + 1;
+			if (sum * 100 < escaped * 99)
+				p99 = i + 1;
+			if (sum * 1000 < escaped * 999)
+				p999 = i + 1;
+		}
+	}
+
+	// The smallest limit, in steps of 64, leaving room above nearly all escape counts
+	// Doubles the limit when too many pixels escape close to it
+	int ProposeIterations(int maxLimit) const
+	{
+		int proposed;
+		if (UnresolvedFraction() > 0.001)
+			proposed = 2 * maxIterations;
+		else
+			proposed = 2 * p999;
+
+		proposed = (proposed + 63) / 64 * 64;
+		return std::min(maxLimit, std::max(64, proposed));
+	}
+
+	// One cycle of the colors over 99% of the escaped pixels
+	float ProposeScale() const
+	{
+		return float(std::max(16, p99));
+	}
+};
@@ -0,0 +1,627 @@
+/*
+	Fractal Bench, benchmarks of the render core of the Fractal Framework
+
+	Renders a fixed set of scenes with every backend of the Methods table, with
+	warmup runs, repetitions and several thread counts, and reports median and 95th
+	percentile times, Mpixels/s and Giterations/s as CSV, and optionally JSON, so
+	builds and machines can be compared.
+
+	Usage, all options can be left out:
+		FractalBench --width 640 --height 480 --warmup 1 --repeat 5
+					 --scenes full,seahorse,interior,burningship,logisticjulia,mandeljulia
+					 --variants plain,loop,convergence,index
+					 --backends openmp,single,cpp17,ppl,tbb --threads 1,4,8
+					 --no-symmetry --counters --csv results.csv --json results.json
+		FractalBench --golden record|check --golden-file FractalFramework.golden
+
+	Thread counts only apply to the backends controlling their threads, the others
+	run once with their default. Iterations are those given by the escape counts, with
+	inside points counted as the full limit, also when the interior method stops earlier.
+	With --counters, the hardware counters of the workers are read around every row, and
+	IPC and the costs per pixel are added, where the counters are available.
+
+	Golden mode checks the engines instead of timing them. Each scene and variant is
+	calculated at a small, fixed size by the scalar reference, and by every backend,
+	with symmetry, into a result buffer, resumed from half the limit and disk filled.
+	Escape counts must be exact. Mirrored views are compared with the reference at
+	the coordinates they are snapped to. Only disk filling, which interpolates, may
+	differ a little. Record stores the reference counts, check first compares the
+	reference with the stored counts, and fails without them. Failures write a
+	heatmap of the differing pixels, as golden-*.ppm.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "RenderCore.h"
+#include "GoldenImages.h"
+
+struct BenchScene
+{
+	const char* name;
+	const char* formula;
+	double centerx, centery;
+	double size;				// World width of the view
+	bool julia;
+	double seedx, seedy;
+	int iterations;
+};
+
+static const std::vector<BenchScene> Scenes =
+{
+	{ "full", "mandelbrot", -0.5, 0.0, 3.0, false, 0.0, 0.0, 256 },
+	{ "seahorse", "mandelbrot", -0.7453, 0.1127, 6.5e-4, false, 0.0, 0.0, 1024 },
+	{ "interior", "mandelbrot", -0.1, 0.0, 0.3, false, 0.0, 0.0, 1024 },
+	{ "burningship", "burningship", -0.4, -0.6, 3.5, false, 0.0, 0.0, 256 },
+	{ "logisticjulia", "logistic", 0.5, 0.0, 1.4, true, 2.551, -0.960, 512 },
+	{ "mandeljulia", "mandelbrot", 0.0, 0.0, 3.2, true, -0.8, 0.156, 512 },		// Point symmetric
+};
+
+static const std::vector<std::string> Variants = { "plain", "loop", "convergence", "index" };
+
+struct BenchOptions
+{
+	int width = 640;
+	int height = 480;
+	int warmup = 1;
+	int repeat = 5;
+	std::vector<std::string> scenes;
+	std::vector<std::string> variants = Variants;
+	std::vector<std::string> backends;
+	std::vector<int> threads;
+	bool symmetry = true;
+	bool counters = false;
+	std::string csv;
+	std::string json;
+	std::string golden;			// record or check, empty for benchmarks
+	std::string goldenFile = "FractalFramework.golden";
+};
+
+struct BenchResult
+{
+	std::string scene, variant, backend;
+	int threads;				// 0 for the default of the backend
+	int iterations;
+	double median, p95;			// Seconds
+	double mpixels, giterations;	// Per second, at the median
+
+	// Per pixel, of the timed runs, when measured
+	bool hardware = false, clock = false;
+	double ipc = 0.0;
+	double cycles = 0.0, instructions = 0.0, branchMisses = 0.0, cacheMisses = 0.0;
+	double cpuNs = 0.0;
+};
+
+static void Usage()
+{
+	std::cerr << "Usage: FractalBench [--width W] [--height H] [--warmup N] [--repeat N]" << std::endl
+			  << "                    [--scenes full,seahorse,interior,burningship,logisticjulia,mandeljulia]" << std::endl
+			  << "                    [--variants plain,loop,convergence,index]" << std::endl
+			  << "                    [--backends openmp,single,cpp17,ppl,tbb] [--threads 1,2,4]" << std::endl
+			  << "                    [--no-symmetry] [--counters] [--csv FILE] [--json FILE]" << std::endl
+			  << "       FractalBench --golden record|check [--golden-file FILE] [--scenes ...] [--variants ...] [--backends ...]" << std::endl;
+}
+
+static std::vector<std::string> SplitList(const std::string& text)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(text);
+	std::string item;
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty())
+			items.push_back(item);
+	}
+	return items;
+}
+
+static bool ParseOptions(int argc, char* argv[], BenchOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+
+		if (option == "--no-symmetry")
+		{
+			options.symmetry = false;
+			continue;
+		}
+		if (option == "--counters")
+		{
+			options.counters = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+			return false;
+		const std::string value = argv[++i];
+
+		if (option == "--width")
+			options.width = std::atoi(value.c_str());
+		else if (option == "--height")
+			options.height = std::atoi(value.c_str());
+		else if (option == "--warmup")
+			options.warmup = std::atoi(value.c_str());
+		else if (option == "--repeat")
+			options.repeat = std::atoi(value.c_str());
+		else if (option == "--scenes")
+			options.scenes = SplitList(value);
+		else if (option == "--variants")
+			options.variants = SplitList(value);
+		else if (option == "--backends")
+			options.backends = SplitList(value);
+		else if (option == "--threads")
+		{
+			options.threads.clear();
+			for (const auto& t : SplitList(value))
+				options.threads.push_back(std::atoi(t.c_str()));
+		}
+		else if (option == "--csv")
+			options.csv = value;
+		else if (option == "--json")
+			options.json = value;
+		else if (option == "--golden")
+			options.golden = value;
+		else if (option == "--golden-file")
+			options.goldenFile = value;
+		else
+			return false;
+	}
+
+	if (options.scenes.empty())
+	{
+		for (const auto& scene : Scenes)
+			options.scenes.push_back(scene.name);
+	}
+
+	if (options.backends.empty())
+	{
+		for (const auto& backend : RenderEngine::Backends())
+			options.backends.push_back(backend.name);
+	}
+
+	// One thread, half and all of the hardware threads
+	if (options.threads.empty())
+	{
+		const int hardware = std::max(1, int(std::thread::hardware_concurrency()));
+		for (int t : { 1, hardware / 2, hardware })
+		{
+			if (t > 0 && std::find(options.threads.begin(), options.threads.end(), t) == options.threads.end())
+				options.threads.push_back(t);
+		}
+	}
+
+	return options.width > 0 && options.height > 0 && options.warmup >= 0 && options.repeat > 0
+		&& (options.golden.empty() || options.golden == "record" || options.golden == "check")
+		&& std::all_of(options.threads.begin(), options.threads.end(), [] (int t) { return t > 0; });
+}
+
+static BenchResult RunBenchmark(const BenchOptions& options, const BenchScene& scene, const std::string& variant, size_t backend, int threads)
+{
+	FormulaDefaults defaults;
+	std::unique_ptr<IComputeState> state(CreateComputeState(scene.formula, defaults));
+	std::unique_ptr<IComputePoint> point(CreateComputePoint(variant));
+	point->z.reset(state->Clone());
+	point->maxIterations = scene.iterations;
+	point->bailOutSquare = defaults.bailoutSquare;
+
+	RenderView view = CenteredView(options.width, options.height, scene.centerx, scene.centery, scene.size);
+	view.julia = scene.julia;
+	view.seedr = scene.seedx;
+	view.seedi = scene.seedy;
+	view.z0r = defaults.z0r;
+	view.z0i = defaults.z0i;
+
+	RenderSettings settings;
+	settings.backend = backend;
+	settings.threads = threads;
+	settings.useSymmetry = options.symmetry;
+
+	PerfTotals counters;
+	if (options.counters)
+		settings.counters = &counters;
+
+	std::vector<int> values(size_t(view.width) * view.height);
+	RenderTarget target;
+	target.values = values.data();
+
+	std::vector<double> times;
+	for (int run = 0; run < options.warmup + options.repeat; run++)
+	{
+		if (run == options.warmup)
+			counters.Reset();
+
+		auto tp1 = std::chrono::high_resolution_clock::now();
+		RenderEngine(view, settings, *point, target).Render();
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - tp1;
+
+		if (run >= options.warmup)
+			times.push_back(elapsed.count());
+	}
+
+	const uint64_t iterations = NominalIterations(values.data(), values.size(), scene.iterations);
+
+	BenchResult result;
+	result.scene = scene.name;
+	result.variant = variant;
+	result.backend = RenderEngine::Backends()[backend].name;
+	result.threads = threads;
+	result.iterations = scene.iterations;
+	result.median = NearestRankPercentile(times, 0.5);
+	result.p95 = NearestRankPercentile(times, 0.95);
+	result.mpixels = values.size() / result.median / 1e6;
+	result.giterations = iterations / result.median / 1e9;
+
+	const PerfCounts counts = counters.Get();
+	const double pixels = double(values.size()) * options.repeat;
+	result.hardware = counters.HasHardware();
+	result.clock = counters.HasClock();
+	result.ipc = counts.IPC();
+	result.cycles = counts.cycles / pixels;
+	result.instructions = counts.instructions / pixels;
+	result.branchMisses = counts.branchMisses / pixels;
+	result.cacheMisses = counts.cacheMisses / pixels;
+	result.cpuNs = counts.taskClock / pixels;
+
+	return result;
+}
+
+static void WriteCsv(std::ostream& out, const std::vector<BenchResult>& results)
+{
+	out << "compiler,isa,scene,variant,backend,threads,iterations,median_ms,p95_ms,mpixels_per_s,giterations_per_s,"
+		<< "ipc,cycles_per_pixel,instructions_per_pixel,branch_misses_per_pixel,cache_misses_per_pixel,cpu_ns_per_pixel" << std::endl;
+	for (const auto& r : results)
+	{
+		out << buildCompilerString() << "," << IsaName(SelectedIsa()) << "," << r.scene << "," << r.variant << "," << r.backend << ","
+			<< (r.threads ? std::to_string(r.threads) : "default") << "," << r.iterations << ","
+			<< r.median * 1e3 << "," << r.p95 * 1e3 << "," << r.mpixels << "," << r.giterations << ",";
+		// Empty where the counters are not available
+		if (r.hardware)
+			out << r.ipc << "," << r.cycles << "," << r.instructions << "," << r.branchMisses << "," << r.cacheMisses;
+		else
+			out << ",,,,";
+		out << ",";
+		if (r.clock)
+			out << r.cpuNs;
+		out << std::endl;
+	}
+}
+
+static void WriteJson(std::ostream& out, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	out << "{" << std::endl
+		<< "  \"compiler\": \"" << buildCompilerString() << "\"," << std::endl
+		<< "  \"isa\": \"" << IsaName(SelectedIsa()) << "\"," << std::endl
+		<< "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << "," << std::endl
+		<< "  \"width\": " << options.width << "," << std::endl
+		<< "  \"height\": " << options.height << "," << std::endl
+		<< "  \"warmup\": " << options.warmup << "," << std::endl
+		<< "  \"repeat\": " << options.repeat << "," << std::endl
+		<< "  \"symmetry\": " << (options.symmetry ? "true" : "false") << "," << std::endl
+		<< "  \"results\": [" << std::endl;
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+		out << "    { \"scene\": \"" << r.scene << "\", \"variant\": \"" << r.variant << "\", \"backend\": \"" << r.backend
+			<< "\", \"threads\": " << r.threads << ", \"iterations\": " << r.iterations
+			<< ", \"medianMs\": " << r.median * 1e3 << ", \"p95Ms\": " << r.p95 * 1e3
+			<< ", \"mpixelsPerS\": " << r.mpixels << ", \"giterationsPerS\": " << r.giterations;
+		if (r.hardware)
+		{
+			out << ", \"ipc\": " << r.ipc << ", \"cyclesPerPixel\": " << r.cycles << ", \"instructionsPerPixel\": " << r.instructions
+				<< ", \"branchMissesPerPixel\": " << r.branchMisses << ", \"cacheMissesPerPixel\": " << r.cacheMisses;
+		}
+		if (r.clock)
+			out << ", \"cpuNsPerPixel\": " << r.cpuNs;
+		out << " }"
+			<< (i + 1 < results.size() ? "," : "") << std::endl;
+	}
+
+	out << "  ]" << std::endl << "}" << std::endl;
+}
+
+// Golden images are small, so all the checks run in seconds
+static const int goldenWidth = 128;
+static const int goldenHeight = 96;
+
+static InteriorMode InteriorModeOf(const std::string& variant)
+{
+	if (variant == "loop")
+		return InteriorMode::Loop;
+	if (variant == "convergence")
+		return InteriorMode::Convergence;
+	if (variant == "index")
+		return InteriorMode::Index;
+	return InteriorMode::Plain;
+}
+
+static const char* SymmetryName(Symmetry symmetry)
+{
+	switch (symmetry)
+	{
+	case Symmetry::RealAxis: return "axis";
+	case Symmetry::Point: return "point";
+	default: return "none";
+	}
+}
+
+static bool CheckEngine(const std::string& caseName, const std::string& engine, const std::vector<int>& reference, const std::vector<int>& values, const GoldenTolerance& tolerance)
+{
+	const GoldenDiff diff = CompareToReference(reference, values.data());
+	const bool ok = diff.Within(tolerance);
+
+	std::cout << caseName << " " << engine << ": " << (ok ? "ok" : "FAILED") << ", " << diff.mismatches << " of " << diff.pixels << " pixels differ";
+	if (diff.mismatches)
+		std::cout << ", by at most " << diff.maxDifference << ", " << diff.meanDifference << " on average";
+	if (!ok)
+	{
+		const std::string path = "golden-" + caseName + "-" + engine + ".ppm";
+		if (WriteHeatmap(path, reference, values.data(), goldenWidth, goldenHeight))
+			std::cout << ", heatmap in " << path;
+	}
+	std::cout << std::endl;
+
+	return ok;
+}
+
+static int RunGolden(const BenchOptions& options, const std::vector<const BenchScene*>& scenes, const std::vector<size_t>& backends)
+{
+	const bool record = options.golden == "record";
+	const GoldenTolerance exact;
+	GoldenTolerance filled;
+	filled.mismatchFraction = 0.05;
+	filled.meanDifference = 0.1;
+
+	GoldenFile golden;
+	if (!record && !golden.Load(options.goldenFile))
+	{
+		std::cerr << "Could not read the golden file " << options.goldenFile << ", record it first" << std::endl;
+		return 1;
+	}
+
+	bool allOk = true;
+	for (const BenchScene* scene : scenes)
+	{
+		for (const auto& variant : options.variants)
+		{
+			const std::string caseName = std::string(scene->name) + "-" + variant;
+
+			FormulaDefaults defaults;
+			std::unique_ptr<IComputeState> state(CreateComputeState(scene->formula, defaults));
+			std::unique_ptr<IComputePoint> point(CreateComputePoint(variant));
+			point->z.reset(state->Clone());
+			point->maxIterations = scene->iterations;
+			point->bailOutSquare = defaults.bailoutSquare;
+
+			RenderView view = CenteredView(goldenWidth, goldenHeight, scene->centerx, scene->centery, scene->size);
+			view.julia = scene->julia;
+			view.seedr = scene->seedx;
+			view.seedi = scene->seedy;
+			view.z0r = defaults.z0r;
+			view.z0i = defaults.z0i;
+
+			const RenderPlan plainPlan = PlanRender(view.width, view.height, view.tlx, view.tly, view.brx, view.bry, SymmetryInfo(), false);
+			const std::vector<int> reference = RenderReference(view, plainPlan, *point);
+
+			if (record)
+			{
+				golden.entries.push_back({ caseName, view.width, view.height, GoldenChecksum(reference), reference });
+				continue;
+			}
+
+			const GoldenFile::Entry* entry = golden.Find(caseName);
+			if (!entry)
+			{
+				std::cout << caseName << " reference: FAILED, not in " << options.goldenFile << std::endl;
+				allOk = false;
+			}
+			else
+			{
+				if (entry->width != view.width || entry->height != view.height)
+				{
+					std::cout << caseName << " reference: FAILED, stored as " << entry->width << "x" << entry->height << std::endl;
+					allOk = false;
+				}
+				else if (entry->checksum != GoldenChecksum(entry->values))
+				{
+					std::cout << caseName << " reference: FAILED, the stored counts don't match their checksum" << std::endl;
+					allOk = false;
+				}
+				else
+					allOk &= CheckEngine(caseName, "reference", entry->values, reference, exact);
+			}
+
+			std::vector<int> values(reference.size());
+			RenderTarget target;
+			target.values = values.data();
+
+			RenderSettings settings;
+			settings.useSymmetry = false;
+
+			for (size_t backend : backends)
+			{
+				settings.backend = backend;
+				std::fill(values.begin(), values.end(), -1);
+				RenderEngine(view, settings, *point, target).Render();
+				allOk &= CheckEngine(caseName, RenderEngine::Backends()[backend].name, reference, values, exact);
+			}
+			settings.backend = backends.front();
+
+			// Mirrored pixels are compared with the reference at the snapped coordinates of the plan
+			{
+				RenderSettings symmetric = settings;
+				symmetric.useSymmetry = true;
+				std::fill(values.begin(), values.end(), -1);
+				const RenderResult result = RenderEngine(view, symmetric, *point, target).Render();
+				allOk &= CheckEngine(caseName, std::string("symmetry-") + SymmetryName(result.plan.symmetry), RenderReference(view, result.plan, *point), values, exact);
+			}
+
+			// The result buffer, packed as the matching ComputePoint* variant
+			{
+				ComputePointFull full;
+				full.z.reset(state->Clone());
+				full.maxIterations = point->maxIterations;
+				full.bailOutSquare = point->bailOutSquare;
+				full.channels = ResultBuffer::ChannelsFor(InteriorModeOf(variant));
+				full.julia = view.julia;
+
+				ResultBuffer results;
+				results.Allocate(view.width, view.height, full.channels);
+				RenderTarget resultsTarget = target;
+				resultsTarget.results = &results;
+				resultsTarget.packMode = InteriorModeOf(variant);
+
+				std::fill(values.begin(), values.end(), -1);
+				RenderEngine(view, settings, full, resultsTarget).Render();
+				allOk &= CheckEngine(caseName, "results", reference, values, exact);
+
+				// All interior channels, as the framework keeps them to switch modes without recalculating
+				full.channels = ChannelCount | ChannelMagnitude2 | ChannelLooped | ChannelPeriod | ChannelConvergence | ChannelIndex;
+				results.Allocate(view.width, view.height, full.channels);
+				std::fill(values.begin(), values.end(), -1);
+				RenderEngine(view, settings, full, resultsTarget).Render();
+				allOk &= CheckEngine(caseName, "allchannels", reference, values, exact);
+			}
+
+			// Half the limit first, then resumed to the full limit, with symmetry as the framework does,
+			// so the mirrored part must be mirrored again and not calculated
+			{
+				RenderSettings symmetric = settings;
+				symmetric.useSymmetry = true;
+				std::fill(values.begin(), values.end(), -1);
+				point->maxIterations = scene->iterations / 2;
+				const RenderResult result = RenderEngine(view, symmetric, *point, target).Render();
+				point->maxIterations = scene->iterations;
+				RenderEngine(view, symmetric, *point, target).Resume(result.plan, scene->iterations / 2);
+				allOk &= CheckEngine(caseName, "resume", RenderReference(view, result.plan, *point), values, exact);
+			}
+
+			{
+				RenderSettings diskFilled = settings;
+				diskFilled.diskFilling = true;
+				std::fill(values.begin(), values.end(), -1);
+				RenderEngine(view, diskFilled, *point, target).Render();
+				allOk &= CheckEngine(caseName, "diskfill", reference, values, filled);
+			}
+		}
+	}
+
+	if (record)
+	{
+		if (!golden.Save(options.goldenFile))
+		{
+			std::cerr << "Could not write " << options.goldenFile << std::endl;
+			return 1;
+		}
+		std::cout << "Recorded " << golden.entries.size() << " golden images in " << options.goldenFile << std::endl;
+		return 0;
+	}
+
+	std::cout << (allOk ? "All engines match the reference" : "Some engines differ from the reference") << std::endl;
+	return allOk ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		Usage();
+		return 1;
+	}
+
+	std::vector<const BenchScene*> scenes;
+	for (const auto& name : options.scenes)
+	{
+		auto found = std::find_if(Scenes.begin(), Scenes.end(), [&name] (const BenchScene& s) { return name == s.name; });
+		if (found == Scenes.end())
+		{
+			std::cerr << "Unknown scene " << name << std::endl;
+			return 1;
+		}
+		scenes.push_back(&*found);
+	}
+
+	std::vector<size_t> backends;
+	for (const auto& name : options.backends)
+	{
+		int backend = RenderEngine::FindBackend(name);
+		if (backend < 0)
+		{
+			std::cerr << "Backend " << name << " is not in this build" << std::endl;
+			return 1;
+		}
+		backends.push_back(size_t(backend));
+	}
+
+	for (const auto& variant : options.variants)
+	{
+		std::unique_ptr<IComputePoint> point(CreateComputePoint(variant));
+		if (!point)
+		{
+			std::cerr << "Unknown variant " << variant << std::endl;
+			return 1;
+		}
+	}
+
+	if (!options.golden.empty())
+		return RunGolden(options, scenes, backends);
+
+	std::cerr << "Fractal Bench, " << buildCompilerString() << ", " << IsaName(SelectedIsa()) << " kernels, " << std::thread::hardware_concurrency() << " hardware threads, "
+			  << options.width << "x" << options.height << std::endl;
+
+	std::vector<BenchResult> results;
+	for (const BenchScene* scene : scenes)
+	{
+		for (const auto& variant : options.variants)
+		{
+			for (size_t backend : backends)
+			{
+				std::vector<int> threadCounts = { 0 };
+				if (RenderEngine::Backends()[backend].threadControl)
+					threadCounts = options.threads;
+
+				for (int threads : threadCounts)
+				{
+					results.push_back(RunBenchmark(options, *scene, variant, backend, threads));
+
+					const BenchResult& r = results.back();
+					std::cerr << r.scene << " " << r.variant << " " << r.backend << " "
+							  << (r.threads ? std::to_string(r.threads) + " threads" : "default threads") << ": "
+							  << r.median * 1e3 << " ms" << std::endl;
+				}
+			}
+		}
+	}
+
+	WriteCsv(std::cout, results);
+
+	if (!options.csv.empty())
+	{
+		std::ofstream file(options.csv);
+		WriteCsv(file, results);
+		if (!file)
+		{
+			std::cerr << "Could not write " << options.csv << std::endl;
+			return 1;
+		}
+	}
+
+	if (!options.json.empty())
+	{
+		std::ofstream file(options.json);
+		WriteJson(file, options, results);
+		if (!file)
+		{
+			std::cerr << "Could not write " << options.json << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
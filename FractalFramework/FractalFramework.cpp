@@ -80,21 +80,6 @@
 #define USE_TBB_WITH_MSC 1
 
 #include <algorithm>
-#include <execution>
-
-#if defined(_MSC_VER)
-#include <ppl.h>
-#if defined(USE_TBB_WITH_MSC)
-	// Demands installation of OneTBB for Windows/MSVC
-	// Also works with clang in VS, but include and lib paths must be set
-	#include <tbb/tbb.h>
-#endif
-#endif
-
-#if defined(__GNUG__)
-#include "tbb/tbb.h"
-#endif
-
 #include <numeric>
 
 #include <cassert>
@@ -106,6 +91,15 @@
 #include "ShiftingColorizer.h"
 
 #include "IterativeCompute.h"
+#include "TileStore.h"
+#include "RenderPlanner.h"
+#include "RenderCore.h"
+#include "ResultBuffer.h"
+#include "PaletteLUT.h"
+#include "HistogramColorizer.h"
+#include "EscapeStatistics.h"
+#include "RenderHistory.h"
+#include "AutoTune.h"
 
 class FractalFramework : public olc::PixelGameEngine
 {
@@ -113,7 +107,8 @@ public:
 	FractalFramework() 
 		: 
 		stripedColorizer(&eColorizer),
-		shiftColorizer(&eColorizer)
+		shiftColorizer(&eColorizer),
+		histogramColorizer(&eColorizer)
 	{
 		sAppName = "Fractal Framework";
 	}
@@ -139,8 +134,159 @@ public:
 
 	bool calculateIndex = false;
 
+	// Keep all interior channels, so switching interior mode needs no recalculation
+	bool useResultBuffer = false;
+	bool smoothColoring = false;	// Continuous escape counts, through the float colorizers
+	bool distanceShading = false;	// Darken by the exterior distance estimate, shows thin filaments
+	double currentPixelSize = 0.0;	// World units per pixel of the current calculation
+
+	// Skip exterior pixels proven to be outside the set by the distance estimate
+	bool diskFilling = false;
+	double diskFilledFraction = 0.0;
+
+	// Hardware performance counters of the calculating threads, read around every row when enabled
+	bool useCounters = false;
+	PerfTotals counters;
+
+	// Time and iterations of the last calculation by tile, shown as a heatmap when enabled
+	bool showCosts = false;
+	CostMap costs;
+
+	// The last completed renders, and how busy each thread was in the last one
+	RenderHistory renderHistory;
+	WorkerLoad workerLoad;
+	std::atomic<int> rendersCompleted{ 0 };	// Counted by the calculating thread, after setting the last render
+	int rendersShown = 0;
+	double lastRenderSeconds = 0.0;		// Of the render core, without antialiasing
+	double lastRenderIterations = 0.0;
+	double loadSeconds = 0.0;			// Of the calculation the worker load is of, a render or a resume
+
+	// Settings of the methods with thread control, from the dashboard, used from the next render
+	int threadCount = 0;				// 0 for the default
+	int grainSize = 1;
+	RenderSchedule schedule = RenderSchedule::Dynamic;
+	const std::string tuneFileName = "FractalFramework.tune";
+
+	// Escape statistics, and the iteration limit and color scale proposed from them
+	std::mutex statisticsMutex;
+	EscapeStatistics statistics;
+	std::atomic<bool> statisticsFresh{ false };
+	bool autoIterations = false;
+	const int maxAutoIterations = 256 * 20;	// The maximum of the iterations slider
+	int proposedIterations = 0;
+	float proposedScale = 0;
+	RenderPlan lastPlan;
+	int resumedFrom = 0;
+	std::atomic<size_t> resumedPixels{ 0 };
+
+	// Histogram equalized colors, the histogram grows with the spans finished by the calculation
+	bool histogramColoring = false;
+	std::mutex histogramMutex;
+	std::vector<HistogramSpan> completedSpans;
+	bool histogramComplete = false;
+
+	// The colorizer chain compiled into a table, rebuilt when the chain changes
+	bool usePalette = true;
+	PaletteLUT palette;
+
+	// Rows of pFractal changed since they were last colored, set by the calculating threads
+	std::unique_ptr<std::atomic<bool>[]> dirtyRows;
+	bool wasCompleted = false;
+
+	// The colored fractal has a layer of its own, below the overlays on layer 0,
+	// so overlays can be drawn again without coloring, and the fractal is only sent to the GPU when it changed
+	uint32_t fractalLayer = 0;
+	olc::Pixel* FractalPixels() { return GetLayers()[fractalLayer].pDrawTarget.Sprite()->GetData(); }
+
+	// Cost of the last drawn frame, for coloring the fractal and for drawing the overlays
+	std::chrono::duration<double> colorTime = std::chrono::duration<double>();
+	std::chrono::duration<double> overlayTime = std::chrono::duration<double>();
+
+	// Everything the colors of the pixels depend on, besides their values
+	struct ColorState
+	{
+		PaletteSignature signature;
+		bool usePalette = false;
+		bool ring = false;
+		const float* pSmooth = nullptr;
+		const float* pDistance = nullptr;
+		float pixelSize = 0;
+		size_t aaPixels = 0;
+
+		bool operator==(const ColorState& other) const
+		{
+			return signature == other.signature && usePalette == other.usePalette && ring == other.ring
+				&& pSmooth == other.pSmooth && pDistance == other.pDistance && pixelSize == other.pixelSize
+				&& aaPixels == other.aaPixels;
+		}
+		bool operator!=(const ColorState& other) const { return !(*this == other); }
+	};
+	ColorState lastColorState;
+
+	// Everything the overlays depend on, when it is the same as the last frame, nothing is drawn
+	struct OverlayState
+	{
+		olc::vi2d mouse;
+		size_t trackLength = 0;
+		olc::vd2d juliaSeed;
+		bool showGui = false;
+		std::vector<std::string> hud;
+		bool showCosts = false;
+		uint64_t costTotal = 0;		// Changes while the costs are being recorded
+
+		// The GUI, when shown: the texts and values of its controls, which are enabled, the control
+		// under the mouse, the button, and the thread load. The hover fades are instant, so nothing else changes it
+		std::vector<std::string> guiTexts;
+		std::vector<float> guiValues;
+		bool guiEnabled = false;
+		int guiHover = -1;
+		bool guiHeld = false;
+		std::vector<uint64_t> guiLoad;
+
+		bool operator==(const OverlayState& other) const
+		{
+			return mouse == other.mouse && trackLength == other.trackLength && juliaSeed == other.juliaSeed
+				&& showGui == other.showGui && hud == other.hud
+				&& showCosts == other.showCosts && costTotal == other.costTotal
+				&& guiTexts == other.guiTexts && guiValues == other.guiValues && guiEnabled == other.guiEnabled
+				&& guiHover == other.guiHover && guiHeld == other.guiHeld && guiLoad == other.guiLoad;
+		}
+		bool operator!=(const OverlayState& other) const { return !(*this == other); }
+	};
+	OverlayState lastOverlayState;
+	bool firstFrame = true;
+	const int idleSleep = 15;	// Milliseconds to sleep in frames with nothing to draw
+
+	// Animated colors as a rotation of a ring, indexed once per calculation
+	PaletteRing paletteRing;
+	std::vector<int> ringIndexes;
+	bool ringIndexesStale = true;
+
+	// Adaptive antialiasing, supersampling only pixels at edges
+	bool antialiasing = false;
+	const int aaGrid = 4;			// aaGrid x aaGrid jittered samples per edge pixel
+	int aaThreshold = 2;			// Neighbours differing more than this are an edge
+	std::mutex aaMutex;				// Guards the published samples below
+	std::vector<int> aaPixels;		// Index of each supersampled pixel
+	std::vector<int> aaValues;		// aaGrid * aaGrid packed values per supersampled pixel
+	std::vector<float> aaSmooth;	// Smooth counts for the same, when smooth coloring
+	std::vector<PointResult> aaResults;	// Results of the same, when in use, to pack them again for another interior mode
+	std::chrono::duration<double> aaTime = std::chrono::duration<double>();
+	ResultBuffer results;
+	bool resultsInUse = false;		// Valid during and after a calculation
+	InteriorMode packMode = InteriorMode::Plain;
+
 	bool recalculate = true;
 
+	// Calculate only one half of symmetric views, and mirror the other half
+	bool useSymmetry = true;
+	double mirroredFraction = 0.0;
+
+	// Persistent store of finished views, so known locations load instantly after a restart
+	TileStore tileStore;
+	RenderKey currentKey;
+	bool loadedFromStore = false;
+
 	std::unique_ptr<IComputeState> m_pCurrentStateAlgorithm;
 	std::unique_ptr<IComputePoint> m_pCurrentPointAlgorithm;
 
@@ -151,6 +297,16 @@ public:
 	olc::QuickGUI::Slider* guiIterationSlider = nullptr;
 	olc::QuickGUI::Label* guiIterationValue = nullptr;
 
+	// Dashboard, next to the iterations
+	std::vector<olc::QuickGUI::Label*> guiDashboardLines;
+	olc::QuickGUI::Label* guiThreadsLabel = nullptr;
+	olc::QuickGUI::Slider* guiThreadsSlider = nullptr;
+	olc::QuickGUI::Label* guiThreadsValue = nullptr;
+	olc::QuickGUI::Label* guiGrainLabel = nullptr;
+	olc::QuickGUI::Slider* guiGrainSlider = nullptr;
+	olc::QuickGUI::Label* guiGrainValue = nullptr;
+	olc::QuickGUI::Button* guiScheduleButton = nullptr;
+	bool guiThreadControls = true;		// The controls are enabled, as the method uses them
 
 public:
 	bool ResetView(olc::Key)
@@ -178,11 +334,17 @@ public:
 	bool OnUserCreate() override
 	{
 		pFractal = new int[ScreenWidth() * ScreenHeight()] { 0 };
+		dirtyRows.reset(new std::atomic<bool>[ScreenHeight()]);
+		MarkAllRowsDirty();
+		fractalLayer = CreateLayer();
+		EnableLayer(uint8_t(fractalLayer), true);
 
 		// Using Vector extensions, align memory (not as necessary as it used to be)
 		// MS Specific - see std::aligned_alloc for others
 		// pFractal = (int*)_aligned_malloc(size_t(ScreenWidth()) * size_t(ScreenHeight()) * sizeof(int), 64);
 
+		tileStore.Open("FractalFramework.tiles", size_t(256) << 20);
+
 		eColorizer.setScale((float) nIterations);
 		oeColorizer.setScale((float) nIterations);
 
@@ -221,6 +383,35 @@ public:
 		guiIterationValue = new olc::QuickGUI::Label(guiManager,
 														std::to_string(nIterations), { 370.0f, ScreenHeight() - 28.f }, { 100.0f, 16.0f });
 
+		// Dashboard: statistics above the controls for the methods with thread control
+		for (int i = 0; i < 4; i++)
+		{
+			auto line = new olc::QuickGUI::Label(guiManager, "", { 490.0f, ScreenHeight() - 92.f + 16.f * i }, { 400.0f, 16.0f });
+			line->nAlign = olc::QuickGUI::Label::Alignment::Left;
+			guiDashboardLines.push_back(line);
+		}
+		const float maxThreads = float(std::max(2u, 2 * std::thread::hardware_concurrency()));
+		guiThreadsLabel = new olc::QuickGUI::Label(guiManager, "Threads", { 490.0f, ScreenHeight() - 28.f }, { 60.0f, 16.0f });
+		guiThreadsSlider = new olc::QuickGUI::Slider(guiManager,
+													 { 560.0f, ScreenHeight() - 20.f }, { 660.0f, ScreenHeight() - 20.f }, 0, maxThreads, float(threadCount));
+		guiThreadsValue = new olc::QuickGUI::Label(guiManager, "", { 665.0f, ScreenHeight() - 28.f }, { 60.0f, 16.0f });
+		guiGrainLabel = new olc::QuickGUI::Label(guiManager, "Grain", { 730.0f, ScreenHeight() - 28.f }, { 50.0f, 16.0f });
+		guiGrainSlider = new olc::QuickGUI::Slider(guiManager,
+												   { 790.0f, ScreenHeight() - 20.f }, { 890.0f, ScreenHeight() - 20.f }, 1, 64, float(grainSize));
+		guiGrainValue = new olc::QuickGUI::Label(guiManager, "", { 895.0f, ScreenHeight() - 28.f }, { 40.0f, 16.0f });
+		guiScheduleButton = new olc::QuickGUI::Button(guiManager, "", { 945.0f, ScreenHeight() - 30.f }, { 130.0f, 20.0f });
+
+		// Without fades the GUI only changes with what the overlay state observes, so idle frames draw nothing
+		guiManager.fHoverSpeedOn = guiManager.fHoverSpeedOff = 1e6f;
+
+		// Tuned for this machine, the first time it runs on it
+		TuneChoice choice;
+		if (TuneFile(tuneFileName).Load(MachineFingerprint(), choice))
+			std::cout << "Tuned for this machine: " << choice.Describe() << std::endl;
+		else
+			choice = RunAutoTune();
+		ApplyTuning(choice);
+
 		return true;
 	}
 
@@ -230,216 +421,310 @@ public:
 		// _aligned_free(pFractal);
 		if (currentHelperThread)
 		{
+			TRACE_SCOPE("cancel and join");
+
 			// Stop the current calculation
 			stopCalculation = true;
+			TRACE_INSTANT("cancel");
 
 			currentHelperThread.get()->join();
 		}
 
 		currentHelperThread.release();
 
+		if (Trace::enabled)
+			WriteTrace(olc::Key::T);
+
 		delete pFractal;
 		return true;
 	}
 
-	// New parallel method, using OpenMP
-	void CreateFractalOpenMP(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int /* iterations */)
+	// Mark finished pixels for drawing, and hand them to the histogram, so it grows while calculating
+	void CompletedSpan(size_t offset, int length)
 	{
-		const double x_scale = (frac_br.x - frac_tl.x) / (double(pix_br.x) - double(pix_tl.x));
-		const double y_scale = (frac_br.y - frac_tl.y) / (double(pix_br.y) - double(pix_tl.y));
+		if (stopCalculation || length <= 0)
+			return;
 
-		const int row_size = ScreenWidth();
+		dirtyRows[offset / ScreenWidth()] = true;
 
-		int y;
+		if (histogramColoring)
+		{
+			std::lock_guard<std::mutex> lock(histogramMutex);
+			completedSpans.push_back({ offset, length });
+		}
+	}
 
+	// Count the spans finished since the last frame
+	// Anything not calculated row by row, like disk filled or stored views, is counted in full at the end
+	void UpdateHistogram()
+	{
+		const bool completed = calculationCompleted;
 
-#pragma omp parallel
-#pragma omp for schedule(dynamic, 1) nowait
-		for (y = pix_tl.y; y < pix_br.y; y++)
+		std::vector<HistogramSpan> spans;
 		{
-			double x_pos = frac_tl.x;
-			const double y_pos = frac_tl.y + y * y_scale;
+			std::lock_guard<std::mutex> lock(histogramMutex);
+			spans.swap(completedSpans);
+		}
+		histogramColorizer.Add(pFractal, spans);
 
-			const int y_offset = y * row_size;
+		if (completed && !histogramComplete)
+		{
+			const size_t size = size_t(ScreenWidth()) * ScreenHeight();
+			if (histogramColorizer.getCounted() != size)
+				histogramColorizer.Build(pFractal, size);
+			histogramComplete = true;
+		}
+	}
 
-			int x, n;
+	void ResetHistogram()
+	{
+		std::lock_guard<std::mutex> lock(histogramMutex);
+		completedSpans.clear();
+		histogramColorizer.Reset(nIterations);
+		histogramComplete = false;
+	}
 
-			// We need a copy for each parallel task, possibly down to each y coordinate
-			std::unique_ptr<IComputePoint> comPoint(m_pCurrentPointAlgorithm->Clone());
+	// Find pixels differing from their neighbours, in escape band or inside/outside,
+	// or closer to the set than a pixel, and supersample just those
+	void Antialias(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const RenderPlan& plan)
+	{
+		const int row_size = ScreenWidth();
+		const int maxIterations = m_pCurrentPointAlgorithm->maxIterations;
+		const float* pDistance = resultsInUse && results.Has(ChannelDistance) ? results.distance.data() : nullptr;
+		const float pixelSize = float(std::abs(plan.x_scale));
 
-			for (x = pix_tl.x; x < pix_br.x && !stopCalculation; x++)
+		auto isEdge = [&] (int a, int b)
 			{
-				if (julia)
-				{
-					n = comPoint->ComputePointCount(juliaSeed.x, juliaSeed.y, x_pos, y_pos);
-				}
-				else
-				{
-					n = comPoint->ComputePointCount(x_pos, y_pos, z0Value.x, z0Value.y);
-				}
+				int va = pFractal[a], vb = pFractal[b];
+				if ((va >= maxIterations) != (vb >= maxIterations))
+					return true;
+				return va < maxIterations && std::abs(va - vb) > aaThreshold;
+			};
 
-				pFractal[y_offset + x] = n;
-				x_pos += x_scale;
+		// Mark the edges, each row in parallel
+		const int height = pix_br.y - pix_tl.y;
+		std::vector<std::vector<int>> rowEdges(height);
+
+		int y;
+#pragma omp parallel for schedule(dynamic, 8)
+		for (y = pix_tl.y; y < pix_br.y; y++)
+		{
+			std::vector<int>& edges = rowEdges[y - pix_tl.y];
+			for (int x = pix_tl.x; x < pix_br.x; x++)
+			{
+				const int i = y * row_size + x;
+				bool edge = (pDistance && pFractal[i] < maxIterations && pDistance[i] < pixelSize)
+					|| (x > pix_tl.x && isEdge(i, i - 1)) || (x + 1 < pix_br.x && isEdge(i, i + 1))
+					|| (y > pix_tl.y && isEdge(i, i - row_size)) || (y + 1 < pix_br.y && isEdge(i, i + row_size));
+				if (edge)
+					edges.push_back(i);
 			}
 		}
-	}
-#if defined(_MSC_VER)
-	// _MSC_VER is also defined for clang under VS (clang-cl)
-	// Using concurrency library parallelization
-	void CreateFractalParallelization(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int /*iterations*/)
-	{
-		const double x_scale = (frac_br.x - frac_tl.x) / (double(pix_br.x) - double(pix_tl.x));
-		const double y_scale = (frac_br.y - frac_tl.y) / (double(pix_br.y) - double(pix_tl.y));
 
-		const int row_size = ScreenWidth();
-
-		concurrency::parallel_for(int(pix_tl.y), int(pix_br.y), [&] (int y)
-								  {
-									  double x_pos = frac_tl.x;
-									  const double y_pos = frac_tl.y + y * y_scale;
-
-									  const int y_offset = y * row_size;
-
-									  int x, n;
-
-									  // We need a copy for each parallel task, possibly down to each y coordinate
-									  std::unique_ptr<IComputePoint> comPoint(m_pCurrentPointAlgorithm->Clone());
-
-									  for (x = pix_tl.x; x < pix_br.x && !stopCalculation; x++)
-									  {
-										  if (julia)
-										  {
-											  n = comPoint->ComputePointCount(juliaSeed.x, juliaSeed.y, x_pos, y_pos);
-										  }
-										  else
-										  {
-											  n = comPoint->ComputePointCount(x_pos, y_pos, z0Value.x, z0Value.y);
-										  }
-
-										  pFractal[y_offset + x] = n;
-										  x_pos += x_scale;
-									  }
-								  });
-	}
-#endif
+		std::vector<int> pixels;
+		for (const auto& edges : rowEdges)
+			pixels.insert(pixels.end(), edges.begin(), edges.end());
 
-#if defined(__GNUG__) || defined(USE_TBB_WITH_MSC)
-	// Using oneTBB library parallelization
-	void CreateFractalTbbParallelization(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int /*iterations*/)
-	{
-		const double x_scale = (frac_br.x - frac_tl.x) / (double(pix_br.x) - double(pix_tl.x));
-		const double y_scale = (frac_br.y - frac_tl.y) / (double(pix_br.y) - double(pix_tl.y));
+		// Supersample them, each pixel in parallel
+		const int samplesPerPixel = aaGrid * aaGrid;
+		const bool keepSmooth = resultsInUse && results.Has(ChannelSmooth);
+		std::vector<int> values(pixels.size() * samplesPerPixel);
+		std::vector<float> smooth(keepSmooth ? values.size() : 0);
+		std::vector<PointResult> sampleResults(resultsInUse ? values.size() : 0);
 
-		const int row_size = ScreenWidth();
+		const int count = int(pixels.size());
+#pragma omp parallel
+		{
+			// One copy for each thread
+			std::unique_ptr<IComputePoint> comPoint(m_pCurrentPointAlgorithm->Clone());
 
-		tbb::parallel_for(int(pix_tl.y), int(pix_br.y), [&] (int y)
+			int p;
+#pragma omp for schedule(dynamic, 64)
+			for (p = 0; p < count; p++)
 			{
-				double x_pos = frac_tl.x;
-				const double y_pos = frac_tl.y + y * y_scale;
-
-				const int y_offset = y * row_size;
+				if (stopCalculation)
+					continue;
 
-				int x, n;
+				const int px = pixels[p] % row_size - pix_tl.x;
+				const int py = pixels[p] / row_size - pix_tl.y;
 
-				// We need a copy for each parallel task, possibly down to each y coordinate
-				std::unique_ptr<IComputePoint> comPoint(m_pCurrentPointAlgorithm->Clone());
-
-				for (x = pix_tl.x; x < pix_br.x && !stopCalculation; x++)
+				for (int s = 0; s < samplesPerPixel; s++)
 				{
-					if (julia)
+					// Stratified, jittered inside each of the aaGrid x aaGrid sub cells
+					uint32_t h = uint32_t(pixels[p]) * 747796405u + uint32_t(s) * 2891336453u;
+					h ^= h >> 16; h *= 0x7feb352du; h ^= h >> 15;
+					const double jx = ((s % aaGrid) + (h & 0xffff) / 65536.0) / aaGrid - 0.5;
+					const double jy = ((s / aaGrid) + (h >> 16) / 65536.0) / aaGrid - 0.5;
+					const double x_pos = plan.tlx + (px + jx) * plan.x_scale;
+					const double y_pos = plan.tly + (py + jy) * plan.y_scale;
+
+					const size_t slot = size_t(p) * samplesPerPixel + s;
+					if (resultsInUse)
 					{
-						n = comPoint->ComputePointCount(juliaSeed.x, juliaSeed.y, x_pos, y_pos);
+						PointResult r;
+						if (julia)
+							comPoint->ComputePointResult(juliaSeed.x, juliaSeed.y, x_pos, y_pos, r);
+						else
+							comPoint->ComputePointResult(x_pos, y_pos, z0Value.x, z0Value.y, r);
+
+						values[slot] = ResultBuffer::PackResult(r, packMode, maxIterations);
+						sampleResults[slot] = r;
+						if (keepSmooth)
+							smooth[slot] = r.smooth;
 					}
+					else if (julia)
+						values[slot] = comPoint->ComputePointCount(juliaSeed.x, juliaSeed.y, x_pos, y_pos);
 					else
-					{
-						n = comPoint->ComputePointCount(x_pos, y_pos, z0Value.x, z0Value.y);
-					}
-
-					pFractal[y_offset + x] = n;
-					x_pos += x_scale;
+						values[slot] = comPoint->ComputePointCount(x_pos, y_pos, z0Value.x, z0Value.y);
 				}
-			});
+			}
+		}
+
+		if (!stopCalculation)
+		{
+			std::lock_guard<std::mutex> lock(aaMutex);
+			aaPixels.swap(pixels);
+			aaValues.swap(values);
+			aaSmooth.swap(smooth);
+			aaResults.swap(sampleResults);
+		}
 	}
-#endif
 
-	// Using built C++17 parallelization
-	void CreateFractalCppForEachAlgorithm(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int /*iterations*/)
+	void MarkAllRowsDirty()
 	{
-		const double x_scale = (frac_br.x - frac_tl.x) / (double(pix_br.x) - double(pix_tl.x));
-		const double y_scale = (frac_br.y - frac_tl.y) / (double(pix_br.y) - double(pix_tl.y));
+		for (int y = 0; y < ScreenHeight(); y++)
+			dirtyRows[y] = true;
+	}
 
-		const int row_size = ScreenWidth();
+	// The rows changed since the last frame, all of them when everything must be colored again
+	std::vector<int> TakeDirtyRows(bool all)
+	{
+		std::vector<int> rows;
+		for (int y = 0; y < ScreenHeight(); y++)
+		{
+			if (dirtyRows[y].exchange(false) || all)
+				rows.push_back(y);
+		}
+		return rows;
+	}
 
-		std::vector<int> indexes(int(pix_br.y - pix_tl.y));
-		std::iota(indexes.begin(), indexes.end(), 0);
+	// Map the results of the rows into the colored frame, rows in parallel
+	// Integer values are looked up in the compiled palette, when it is used,
+	// otherwise each row is colorized as one span, and the inside values fixed after
+	void ColorizeRows(const IColorizer& colorizer, const float* pSmooth, const float* pDistance, float pixelSize, const std::vector<int>& rows)
+	{
+		TRACE_SCOPE("colorize");
+		const PaletteLUT* pPalette = usePalette ? &palette : nullptr;
+		olc::Pixel* pTarget = FractalPixels();
+		const int width = ScreenWidth();
+		const int count = int(rows.size());
+
+		int r;
+#pragma omp parallel for schedule(static)
+		for (r = 0; r < count; r++)
+		{
+			const int yOffset = rows[r] * width;
+			if (pSmooth)
+				colorizer.ColorizeSpan(pSmooth + yOffset, pTarget + yOffset, width);
+			else if (!pPalette)
+				colorizer.ColorizeSpan(pFractal + yOffset, pTarget + yOffset, width);
 
-		std::for_each_n(std::execution::par, indexes.begin(), int(pix_br.y - pix_tl.y), [&](int y)
+			for (int x = 0; x < width; x++)
 			{
-				double x_pos = frac_tl.x;
-				const double y_pos = frac_tl.y + y * y_scale;
-
-				const int y_offset = y * row_size;
-
-				int x, n;
-
-				// We need a copy for each parallel task, possibly down to each y coordinate
-				std::unique_ptr<IComputePoint> comPoint(m_pCurrentPointAlgorithm->Clone());
-
-				for (x = pix_tl.x; x < pix_br.x &&!stopCalculation; x++)
+				const int i = yOffset + x;
+				const int v = pFractal[i];
+				if (v >= nIterations)
+					pTarget[i] = ColorizeValue(colorizer, pPalette, v, nullptr);
+				else if (pPalette && !pSmooth)
+					pTarget[i] = pPalette->Lookup(colorizer, v);
+
+				if (pDistance && v < nIterations)
 				{
-					if (julia)
-					{
-						n = comPoint->ComputePointCount(juliaSeed.x, juliaSeed.y, x_pos, y_pos);
-					}
-					else
-					{
-						n = comPoint->ComputePointCount(x_pos, y_pos, z0Value.x, z0Value.y);
-					}
-
-					pFractal[y_offset + x] = n;
-					x_pos += x_scale;
+					// Fade to black closer than one pixel from the set
+					float t = std::min(1.0f, pDistance[i] / pixelSize);
+					pTarget[i] = pTarget[i] * std::sqrt(std::sqrt(t));
 				}
-			});
+			}
+		}
+
+		if (count > 0)
+			DrawAntialiased(colorizer, pPalette, pSmooth, pTarget);
 	}
 
-	// Using single thread
-	void CreateFractalSingleThread(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int /*iterations*/)
+	// Animated colors, just an offset into the ring for each pixel
+	// The ring positions are only found again for rows with new values
+	void RotateRows(const IColorizer& colorizer, int shift, const std::vector<int>& dataRows, const std::vector<int>& rows)
 	{
-		const double x_scale = (frac_br.x - frac_tl.x) / (double(pix_br.x) - double(pix_tl.x));
-		const double y_scale = (frac_br.y - frac_tl.y) / (double(pix_br.y) - double(pix_tl.y));
-
-		const int row_size = ScreenWidth();
+		TRACE_SCOPE("colorize");
+		olc::Pixel* pTarget = FractalPixels();
+		const int width = ScreenWidth();
+		const int size = width * ScreenHeight();
 
-		int y;
-		// We only need one for the whole picture
-		std::unique_ptr<IComputePoint> comPoint(m_pCurrentPointAlgorithm->Clone());
+		if (ringIndexesStale)
+		{
+			ringIndexes.resize(size);
+			paletteRing.Index(pFractal, ringIndexes.data(), size, nIterations);
+			ringIndexesStale = false;
+		}
+		else
+		{
+			for (int y : dataRows)
+				paletteRing.Index(pFractal + y * width, ringIndexes.data() + y * width, width, nIterations);
+		}
 
-		for (y = pix_tl.y; y < pix_br.y && !stopCalculation; y++)
+		if (int(rows.size()) == ScreenHeight())
+		{
+			paletteRing.Rotate(ringIndexes.data(), pTarget, size, shift);
+		}
+		else
 		{
-			double x_pos = frac_tl.x;
-			const double y_pos = frac_tl.y + y * y_scale;
+			for (int y : rows)
+				paletteRing.Rotate(ringIndexes.data() + y * width, pTarget + y * width, width, shift);
+		}
 
-			const int y_offset = y * row_size;
+		if (!rows.empty())
+			DrawAntialiased(colorizer, nullptr, nullptr, pTarget);
+	}
 
-			int x, n;
+	// Overwrite the supersampled pixels with the average color of their samples
+	void DrawAntialiased(const IColorizer& colorizer, const PaletteLUT* pPalette, const float* pSmooth, olc::Pixel* pTarget)
+	{
+		if (antialiasing)
+		{
+			std::lock_guard<std::mutex> lock(aaMutex);
 
-			for (x = pix_tl.x; x < pix_br.x && !stopCalculation; x++)
+			const int samplesPerPixel = aaGrid * aaGrid;
+			const int count = int(aaPixels.size());
+			int p;
+#pragma omp parallel for schedule(static)
+			for (p = 0; p < count; p++)
 			{
-				if (julia)
-				{
-					n = comPoint->ComputePointCount(juliaSeed.x, juliaSeed.y, x_pos, y_pos);
-				}
-				else
+				int r = 0, g = 0, b = 0;
+				for (int s = 0; s < samplesPerPixel; s++)
 				{
-					n = comPoint->ComputePointCount(x_pos, y_pos, z0Value.x, z0Value.y);
+					const size_t slot = size_t(p) * samplesPerPixel + s;
+					olc::Pixel c = ColorizeValue(colorizer, pPalette, aaValues[slot], pSmooth && !aaSmooth.empty() ? &aaSmooth[slot] : nullptr);
+					r += c.r;
+					g += c.g;
+					b += c.b;
 				}
-
-				pFractal[y_offset + x] = n;
-				x_pos += x_scale;
+				pTarget[aaPixels[p]] = olc::Pixel(r / samplesPerPixel, g / samplesPerPixel, b / samplesPerPixel);
 			}
 		}
 	}
 
+	// Color of a single packed value
+	olc::Pixel ColorizeValue(const IColorizer& colorizer, const PaletteLUT* pPalette, int i, const float* pSmooth) const
+	{
+		if (pPalette && (i >= nIterations || !pSmooth))
+			return pPalette->Lookup(colorizer, i);
+
+		if (i >= nIterations)
+			return i == nIterations ? olc::BLACK : colorizer.ColorizePixel(i - nIterations);
+		else
+			return pSmooth ? colorizer.ColorizePixel(*pSmooth) : colorizer.ColorizePixel(i);
+	}
+
 	std::atomic<bool> stopCalculation;
 	std::atomic<bool> calculationCompleted;
 
@@ -448,27 +733,242 @@ public:
 	void ThreadFunction(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int /*iterations*/)
 	{
 
+		TRACE_SCOPE("calculation");
+
 		// START TIMING
 		auto tp1 = std::chrono::high_resolution_clock::now();
+		counters.Reset();
 
-		// Do the computation
-		// Select the right method from the Create Methods table
-		(this->*Methods[nMode].pCreateMethod)(pix_tl, pix_br, frac_tl, frac_br, nIterations);
+		// Do the computation, with the backend selected from the Methods table
+		RenderEngine engine(MakeRenderView(pix_tl, pix_br, frac_tl, frac_br), MakeRenderSettings(), *m_pCurrentPointAlgorithm, MakeRenderTarget(), MakeRenderCallbacks());
+		RenderResult result = engine.Render();
+		const std::chrono::duration<double> renderTime = std::chrono::high_resolution_clock::now() - tp1;
+		lastPlan = result.plan;
+		mirroredFraction = result.mirroredFraction;
+		diskFilledFraction = result.diskFilledFraction;
+
+		if (antialiasing && !stopCalculation)
+		{
+			TRACE_SCOPE("antialias");
+			auto tpAA = std::chrono::high_resolution_clock::now();
+			Antialias(pix_tl, pix_br, result.plan);
+			aaTime = std::chrono::high_resolution_clock::now() - tpAA;
+		}
 
 		// STOP TIMING
 		auto tp2 = std::chrono::high_resolution_clock::now();
 		elapsedTime = tp2 - tp1;
 
+		if (!stopCalculation)
+		{
+			GatherStatistics();
+
+			lastRenderSeconds = loadSeconds = renderTime.count();
+			lastRenderIterations = double(NominalIterations(pFractal, size_t(ScreenWidth()) * ScreenHeight(), m_pCurrentPointAlgorithm->maxIterations));
+			rendersCompleted++;
+		}
+
+		// Disk filled pixels are approximations, don't keep them
+		// Supersamples are not stored either, so antialiased views must be calculated
+		if (!stopCalculation && !resultsInUse && !diskFilling && !antialiasing)
+		{
+			tileStore.Store(currentKey, pFractal, size_t(ScreenWidth()) * size_t(ScreenHeight()));
+		}
+
 		calculationCompleted = true;
 	}
 
+	// The current view, settings and buffers, as the render core takes them
+	RenderView MakeRenderView(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br) const
+	{
+		RenderView view;
+
+		view.width = pix_br.x - pix_tl.x;
+		view.height = pix_br.y - pix_tl.y;
+		view.tlx = frac_tl.x;
+		view.tly = frac_tl.y;
+		view.brx = frac_br.x;
+		view.bry = frac_br.y;
+		view.julia = julia;
+		view.seedr = juliaSeed.x;
+		view.seedi = juliaSeed.y;
+		view.z0r = z0Value.x;
+		view.z0i = z0Value.y;
+
+		return view;
+	}
+
+	RenderSettings MakeRenderSettings()
+	{
+		RenderSettings settings;
+
+		settings.backend = size_t(RenderEngine::FindBackend(Methods[nMode].backend));
+		settings.threads = threadCount;
+		settings.grain = grainSize;
+		settings.schedule = schedule;
+		settings.load = &workerLoad;
+		settings.useSymmetry = useSymmetry;
+		settings.diskFilling = diskFilling;
+		settings.counters = useCounters ? &counters : nullptr;
+		settings.costs = showCosts ? &costs : nullptr;
+
+		return settings;
+	}
+
+	RenderTarget MakeRenderTarget()
+	{
+		RenderTarget target;
+
+		target.values = pFractal;
+		if (resultsInUse)
+		{
+			target.results = &results;
+			target.packMode = packMode;
+		}
+
+		return target;
+	}
+
+	RenderCallbacks MakeRenderCallbacks()
+	{
+		RenderCallbacks callbacks;
+
+		callbacks.progress = [this] (size_t offset, int length) { CompletedSpan(offset, length); };
+		callbacks.cancelled = [this] () { return bool(stopCalculation); };
+
+		return callbacks;
+	}
+
 	std::chrono::duration<double> elapsedTime = std::chrono::duration<double>();
 
-	using CreateFractalFunction = void(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, const int iterations);
+	// Statistics of the last completed view, taken by the thread that completed it
+	void GatherStatistics()
+	{
+		TRACE_SCOPE("statistics");
+		std::lock_guard<std::mutex> lock(statisticsMutex);
+		statistics.Gather(pFractal, size_t(ScreenWidth()) * ScreenHeight(), m_pCurrentPointAlgorithm->maxIterations);
+		statisticsFresh = true;
+	}
+
+	// More iterations for a completed view: only the pixels at the old limit are calculated again,
+	// the escaped pixels keep their counts, as a higher limit doesn't change those
+	void ResumeFunction(const olc::vi2d pix_tl, const olc::vi2d pix_br, const olc::vd2d frac_tl, const olc::vd2d frac_br, const int oldIterations)
+	{
+		TRACE_SCOPE("calculation");
+		auto tp1 = std::chrono::high_resolution_clock::now();
+
+		RenderEngine engine(MakeRenderView(pix_tl, pix_br, frac_tl, frac_br), MakeRenderSettings(), *m_pCurrentPointAlgorithm, MakeRenderTarget(), MakeRenderCallbacks());
+		resumedPixels = engine.Resume(lastPlan, oldIterations);
+		const std::chrono::duration<double> resumeTime = std::chrono::high_resolution_clock::now() - tp1;
+		elapsedTime += resumeTime;
+		loadSeconds = resumeTime.count();
+
+		if (!stopCalculation)
+		{
+			GatherStatistics();
+
+			if (!resultsInUse && !diskFilling && !antialiasing)
+				tileStore.Store(currentKey, pFractal, size_t(ScreenWidth()) * size_t(ScreenHeight()));
+		}
+
+		calculationCompleted = true;
+	}
+
+	// Raise the limit of the completed view to newIterations, calculating only what is needed
+	void ResumeIterations(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br, int newIterations)
+	{
+		TRACE_SCOPE("resume iterations");
+		if (currentHelperThread)
+		{
+			TRACE_SCOPE("join");
+			currentHelperThread.get()->join();
+		}
+
+		const int oldIterations = nIterations;
+		nIterations = newIterations;
+		m_pCurrentPointAlgorithm->maxIterations = nIterations;
+		resumedFrom = oldIterations;
+
+		stopCalculation = false;
+		calculationCompleted = false;
+		currentKey = MakeRenderKey(pix_tl, pix_br, frac_tl, frac_br);
+		MarkAllRowsDirty();
+		ResetHistogram();
+		costs.Reset(pix_br.x - pix_tl.x, pix_br.y - pix_tl.y);
+		workerLoad.Reset();
+
+		currentHelperThread.reset(new std::thread { &FractalFramework::ResumeFunction, this, pix_tl, pix_br, frac_tl, frac_br, oldIterations });
+	}
+
+	// Propose the iteration limit and color scale from the statistics,
+	// and apply them when automatic
+	void UpdateProposals(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br)
+	{
+		if (!statisticsFresh || !calculationCompleted)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(statisticsMutex);
+			statisticsFresh = false;
+			proposedIterations = statistics.ProposeIterations(maxAutoIterations);
+			proposedScale = statistics.ProposeScale();
+		}
+
+		if (autoIterations)
+		{
+			eColorizer.setScale(proposedScale);
+			oeColorizer.setScale(proposedScale);
+
+			// Only grow automatically, lowering the limit would change the image
+			// Antialiased views are calculated again, their supersamples can't be resumed
+			if (proposedIterations > nIterations)
+			{
+				if (antialiasing)
+				{
+					nIterations = proposedIterations;
+					recalculate |= true;
+				}
+				else
+				{
+					ResumeIterations(pix_tl, pix_br, frac_tl, frac_br, proposedIterations);
+				}
+			}
+		}
+	}
+
+	RenderKey MakeRenderKey(const olc::vi2d& pix_tl, const olc::vi2d& pix_br, const olc::vd2d& frac_tl, const olc::vd2d& frac_br) const
+	{
+		RenderKey key;
+
+		key.setNames(m_pCurrentStateAlgorithm->Name(), m_pCurrentPointAlgorithm->Name());
+		key.julia = julia;
+		key.width = pix_br.x - pix_tl.x;
+		key.height = pix_br.y - pix_tl.y;
+		key.iterations = nIterations;
+		key.symmetry = useSymmetry;
+		key.bailout = bailoutSquared;
+		// Only the values actually used by the calculation, so they don't spoil the key
+		if (julia)
+		{
+			key.seedr = juliaSeed.x;
+			key.seedi = juliaSeed.y;
+		}
+		else
+		{
+			key.z0r = z0Value.x;
+			key.z0i = z0Value.y;
+		}
+		key.tlx = frac_tl.x;
+		key.tly = frac_tl.y;
+		key.brx = frac_br.x;
+		key.bry = frac_br.y;
+
+		return key;
+	}
 
 	struct method_s {
 		olc::Key key;
-		CreateFractalFunction FractalFramework::* pCreateMethod;
+		std::string backend;	// Name of the render core backend
 		std::string description;
 	};
 
@@ -498,6 +998,25 @@ public:
 	int loopLength = 0;
 	size_t currentColorizer = 0;
 
+	bool ToggleHistogramColoring(olc::Key)
+	{
+		histogramColoring = !histogramColoring;
+		ResetHistogram();
+
+		return true;
+	}
+
+	bool ToggleAutoIterations(olc::Key)
+	{
+		autoIterations = !autoIterations;
+
+		// Apply the proposals of the current view at once
+		std::lock_guard<std::mutex> lock(statisticsMutex);
+		statisticsFresh = statistics.pixels > 0;
+
+		return true;
+	}
+
 	bool ToggleStripes(olc::Key)
 	{
 		// Toggle striped
@@ -523,7 +1042,7 @@ public:
 				calculateIndex = false;
 		}
 
-		recalculate |= true;
+		InteriorModeChanged();
 
 		return true;
 	}
@@ -533,6 +1052,410 @@ public:
 		// Toggle convergence calculation
 		calculateConvergence = !calculateConvergence;
 
+		InteriorModeChanged();
+
+		return true;
+	}
+
+	InteriorMode CurrentInteriorMode() const
+	{
+		// Same priority as when selecting the ComputePoint variant
+		if (calculateConvergence)
+			return InteriorMode::Convergence;
+		else if (loopCheck)
+			return InteriorMode::Loop;
+		else if (calculateIndex)
+			return InteriorMode::Index;
+		else
+			return InteriorMode::Plain;
+	}
+
+	void InteriorModeChanged()
+	{
+		InteriorMode mode = CurrentInteriorMode();
+
+		if (resultsInUse && calculationCompleted && !recalculate
+			&& results.Has(ResultBuffer::ChannelsFor(mode)))
+		{
+			// Everything is known already, just show it differently
+			packMode = mode;
+			results.PackAll(pFractal, packMode, nIterations);
+			{
+				std::lock_guard<std::mutex> lock(aaMutex);
+				for (size_t i = 0; i < aaResults.size(); i++)
+					aaValues[i] = ResultBuffer::PackResult(aaResults[i], packMode, nIterations);
+			}
+			MarkAllRowsDirty();
+		}
+		else
+		{
+			recalculate |= true;
+		}
+	}
+
+	bool NeedsResultBuffer() const
+	{
+		return useResultBuffer || smoothColoring || distanceShading;
+	}
+
+	unsigned RequiredChannels() const
+	{
+		// All interior modes, or just the current one
+		unsigned channels = useResultBuffer
+			? ChannelCount | ChannelMagnitude2 | ChannelLooped | ChannelPeriod | ChannelConvergence | ChannelIndex
+			: ResultBuffer::ChannelsFor(CurrentInteriorMode());
+		if (smoothColoring)
+			channels |= ChannelSmooth;
+		if (distanceShading)
+			channels |= ChannelDistance;
+		return channels;
+	}
+
+	void ChannelsChanged()
+	{
+		// Recalculate only if the needed channels are not there
+		if (NeedsResultBuffer() && !(resultsInUse && results.Has(RequiredChannels())))
+			recalculate |= true;
+	}
+
+	bool ToggleSmoothColoring(olc::Key)
+	{
+		smoothColoring = !smoothColoring;
+
+		ChannelsChanged();
+
+		return true;
+	}
+
+	bool ToggleDistanceShading(olc::Key)
+	{
+		distanceShading = !distanceShading;
+
+		ChannelsChanged();
+
+		return true;
+	}
+
+	bool ToggleDiskFilling(olc::Key)
+	{
+		diskFilling = !diskFilling;
+
+		recalculate |= true;
+
+		return true;
+	}
+
+	bool ToggleCounters(olc::Key)
+	{
+		useCounters = !useCounters;
+
+		// Calculate again, to measure the current view
+		recalculate |= true;
+
+		return true;
+	}
+
+	bool ToggleCosts(olc::Key)
+	{
+		if (GetKey(olc::Key::SHIFT).bPressed || GetKey(olc::Key::SHIFT).bHeld)
+		{
+			// Export the costs of the last calculation
+			const std::string path = "costmap.csv";
+			if (costs.WriteCsv(path))
+				std::cout << "Costs of " << costs.Columns() << " x " << costs.Rows() << " tiles written to " << path << std::endl;
+			else
+				std::cout << "Could not write " << path << std::endl;
+
+			return true;
+		}
+
+		showCosts = !showCosts;
+
+		// Calculate again, to measure the current view
+		if (showCosts)
+			recalculate |= true;
+
+		return true;
+	}
+
+	bool WriteTrace(olc::Key)
+	{
+		const std::string path = "trace.json";
+		if (Trace::Write(path))
+			std::cout << "Trace written to " << path << ", open it in chrome://tracing or ui.perfetto.dev" << std::endl;
+		else if (!Trace::enabled)
+			std::cout << "Tracing is not built in, build with FRACTAL_TRACE defined" << std::endl;
+		else
+			std::cout << "Could not write " << path << std::endl;
+
+		return true;
+	}
+
+	bool AutoTune(olc::Key)
+	{
+		if (currentHelperThread)
+		{
+			// Stop the current calculation, the tuning needs all threads
+			stopCalculation = true;
+			currentHelperThread.get()->join();
+			currentHelperThread.reset();
+		}
+
+		ApplyTuning(RunAutoTune());
+
+		recalculate |= true;
+
+		return true;
+	}
+
+	// Measure the candidates, and keep the fastest for this machine
+	TuneChoice RunAutoTune()
+	{
+		const std::string fingerprint = MachineFingerprint();
+		std::cout << "Auto-tuning for " << fingerprint << std::endl;
+
+		AutoTuner tuner;
+		tuner.progress = [] (const TuneChoice& c) { std::cout << c.Describe() << ": " << c.seconds * 1000 << " ms" << std::endl; };
+		TuneChoice choice = tuner.Run();
+
+		std::cout << "Fastest: " << choice.Describe() << std::endl;
+		if (!TuneFile(tuneFileName).Save(fingerprint, choice))
+			std::cout << "Could not write " << tuneFileName << std::endl;
+
+		return choice;
+	}
+
+	// Select the method and its settings, the method only when it is in the Methods table
+	void ApplyTuning(const TuneChoice& choice)
+	{
+		for (size_t i = 0; i < Methods.size(); i++)
+		{
+			if (Methods[i].backend == choice.backend)
+				nMode = i;
+		}
+		threadCount = choice.threads;
+		grainSize = choice.grain;
+		schedule = choice.schedule;
+
+		guiThreadsSlider->fValue = float(threadCount);
+		guiGrainSlider->fValue = float(grainSize);
+	}
+
+	// Take the renders completed since the last frame into the history, and show it
+	void UpdateDashboard()
+	{
+		const int completed = rendersCompleted;
+		if (completed != rendersShown)
+		{
+			rendersShown = completed;
+			renderHistory.Add(lastRenderSeconds, double(ScreenWidth()) * ScreenHeight(), lastRenderIterations);
+		}
+
+		if (!bShowGui)
+			return;
+
+		auto ms = [] (double seconds) { return std::to_string(int(seconds * 1000 + 0.5)); };
+		guiDashboardLines[0]->sText = "Render ms: last " + (renderHistory.Count() ? ms(renderHistory.Last().seconds) : std::string("-"))
+			+ ", median " + ms(renderHistory.Median()) + ", p95 " + ms(renderHistory.P95())
+			+ " (" + std::to_string(renderHistory.Count()) + " renders)";
+		guiDashboardLines[1]->sText = "Speed: " + std::to_string(renderHistory.MPixelsPerSecond()) + " Mpixels/s, "
+			+ std::to_string(renderHistory.GIterationsPerSecond()) + " Giterations/s";
+		guiDashboardLines[2]->sText = "Skipped: " + std::to_string(int(100 * mirroredFraction)) + "% mirrored, "
+			+ std::to_string(int(100 * diskFilledFraction)) + "% disk filled";
+
+		const uint64_t hits = tileStore.getHits(), misses = tileStore.getMisses();
+		guiDashboardLines[3]->sText = "Disk store: " + std::to_string(hits) + " hits, " + std::to_string(misses) + " misses"
+			+ (hits + misses ? " (" + std::to_string(int(100.0 * hits / (hits + misses))) + "% hit rate)" : "");
+
+		guiThreadsValue->sText = threadCount ? std::to_string(threadCount) : "default";
+		guiGrainValue->sText = std::to_string(grainSize);
+		guiScheduleButton->sText = std::string("Schedule: ") + ScheduleName(schedule);
+
+		// Only enabled for the methods using them, switching state only on a change, as it ends a drag
+		const int backend = RenderEngine::FindBackend(Methods[nMode].backend);
+		const bool threadControls = backend >= 0 && RenderEngine::Backends()[backend].threadControl;
+		if (threadControls != guiThreadControls)
+		{
+			guiThreadControls = threadControls;
+			guiThreadsSlider->Enable(threadControls);
+			guiGrainSlider->Enable(threadControls);
+			guiScheduleButton->Enable(threadControls);
+		}
+	}
+
+	// What the GUI shows, to draw it only when that changes
+	void ObserveGui(OverlayState& state)
+	{
+		for (const auto* label : { guiIterationValue, guiThreadsValue, guiGrainValue })
+			state.guiTexts.push_back(label->sText);
+		for (const auto* line : guiDashboardLines)
+			state.guiTexts.push_back(line->sText);
+		state.guiTexts.push_back(guiScheduleButton->sText);
+		state.guiEnabled = guiThreadControls;
+
+		// The control under the mouse: the grab of a slider, or the button
+		const olc::vf2d mouse = GetMousePos();
+		const olc::QuickGUI::Slider* sliders[] = { guiIterationSlider, guiThreadsSlider, guiGrainSlider };
+		for (int i = 0; i < 3; i++)
+		{
+			const auto* s = sliders[i];
+			state.guiValues.push_back(s->fValue);
+
+			const olc::vf2d grab = s->vPosMin + (s->vPosMax - s->vPosMin) * ((s->fValue - s->fMin) / (s->fMax - s->fMin));
+			if ((mouse - grab).mag2() <= guiManager.fGrabRad * guiManager.fGrabRad)
+				state.guiHover = i;
+		}
+		const auto* b = guiScheduleButton;
+		if (mouse.x >= b->vPos.x && mouse.x < b->vPos.x + b->vSize.x && mouse.y >= b->vPos.y && mouse.y < b->vPos.y + b->vSize.y)
+			state.guiHover = 3;
+		state.guiHeld = GetMouse(olc::Mouse::LEFT).bHeld;
+
+		if (calculationCompleted)
+		{
+			for (int i = 0; i < workerLoad.Workers(); i++)
+				state.guiLoad.push_back(workerLoad.Busy(i));
+		}
+	}
+
+	// A bar for every thread of the last calculation, with the part of the calculation it was busy
+	void DrawWorkerLoad(const olc::vi2d& pos, const olc::vi2d& size)
+	{
+		DrawString(pos, "Thread utilisation", olc::WHITE);
+
+		const int workers = workerLoad.Workers();
+		if (!calculationCompleted || workers == 0 || loadSeconds <= 0)
+			return;
+
+		const int top = pos.y + 12, height = size.y - 12;
+		const int width = std::max(2, std::min(16, size.x / workers - 1));
+		for (int i = 0; i < workers; i++)
+		{
+			const double busy = std::min(1.0, workerLoad.Busy(i) / 1e9 / loadSeconds);
+			const int h = int(busy * height + 0.5);
+			const int x = pos.x + i * (width + 1);
+
+			DrawRect({ x, top }, { width - 1, height - 1 }, olc::DARK_GREY);
+			FillRect({ x, top + height - h }, { width, h }, busy > 0.8 ? olc::GREEN : busy > 0.5 ? olc::YELLOW : olc::RED);
+		}
+	}
+
+	// Blend the time of every tile over the fractal, from blue for the cheapest to red for the most expensive
+	// Tiles without cost, mirrored or filled, are left clear
+	void DrawCosts(const olc::vi2d& pix_tl)
+	{
+		const double maxCost = double(costs.MaxNanoseconds());
+		if (maxCost <= 0)
+			return;
+
+		for (int r = 0; r < costs.Rows(); r++)
+		{
+			for (int c = 0; c < costs.Columns(); c++)
+			{
+				const uint64_t cost = costs.Nanoseconds(c, r);
+				if (!cost)
+					continue;
+
+				// The square root shows the differences between the cheaper tiles as well
+				const double t = std::sqrt(cost / maxCost);
+				const olc::Pixel color(uint8_t(255 * t), 0, uint8_t(255 * (1 - t)), 112);
+				FillRect(pix_tl + olc::vi2d{ c, r } * CostMap::tileSize, { CostMap::tileSize, CostMap::tileSize }, color);
+			}
+		}
+	}
+
+	// The selected colorizer, inside the decorators that are turned on
+	IColorizer* EffectiveColorizer(std::string* description = nullptr)
+	{
+		IColorizer* colorizer = basicColorizer;
+		std::string name = Colorizers[currentColorizer].description;
+
+		if (histogramColoring)
+		{
+			histogramColorizer.setCore(colorizer);
+			colorizer = &histogramColorizer;
+			name = "Histogram(" + name + ")";
+		}
+
+		if (striped)
+		{
+			stripedColorizer.setCore(colorizer);
+			colorizer = &stripedColorizer;
+			name = "Stripe(" + name + ")";
+		}
+
+		if (shifting)
+		{
+			shiftColorizer.setCore(colorizer);
+			colorizer = &shiftColorizer;
+			name = "Shift(" + name + ")";
+		}
+
+		if (description)
+			*description = name;
+		return colorizer;
+	}
+
+	// Speed of each colorizer, per pixel and as spans, on the current values
+	// The colorizers of the list, Eriksson, and the one in use, with its decorators
+	bool BenchmarkColorizers(olc::Key)
+	{
+		const size_t size = size_t(ScreenWidth()) * ScreenHeight();
+		std::vector<int> values(pFractal, pFractal + size);
+		std::vector<float> floats(values.begin(), values.end());
+		std::vector<olc::Pixel> out(size);
+
+		auto measure = [&] (auto&& f)
+			{
+				auto tp1 = std::chrono::high_resolution_clock::now();
+				f();
+				std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - tp1;
+				return size / elapsed.count() / 1e6;
+			};
+
+		std::cout << "Colorizer benchmark, " << size << " pixels, Mpixels per second" << std::endl;
+		std::cout << "Colorizer\tint pixel\tint span\tfloat pixel\tfloat span" << std::endl;
+		std::vector<colorizer_s> colorizers = Colorizers;
+		colorizers.insert(colorizers.begin(), colorizer_s{ "Eriksson", &eColorizer });
+		std::string current;
+		IColorizer* effectiveColorizer = EffectiveColorizer(&current);
+		if (effectiveColorizer != basicColorizer)
+			colorizers.push_back(colorizer_s{ current, effectiveColorizer });
+
+		for (const auto& c : colorizers)
+		{
+			const IColorizer& colorizer = *c.pColorizer;
+			double intPixel = measure([&] { for (size_t i = 0; i < size; i++) out[i] = colorizer.ColorizePixel(values[i]); });
+			double intSpan = measure([&] { colorizer.ColorizeSpan(values.data(), out.data(), size); });
+			double floatPixel = measure([&] { for (size_t i = 0; i < size; i++) out[i] = colorizer.ColorizePixel(floats[i]); });
+			double floatSpan = measure([&] { colorizer.ColorizeSpan(floats.data(), out.data(), size); });
+			std::cout << c.description << "\t" << intPixel << "\t" << intSpan << "\t" << floatPixel << "\t" << floatSpan << std::endl;
+		}
+
+		return true;
+	}
+
+	bool TogglePalette(olc::Key)
+	{
+		usePalette = !usePalette;
+		palette.Invalidate();
+		paletteRing.Invalidate();
+
+		return true;
+	}
+
+	bool ToggleAntialiasing(olc::Key)
+	{
+		antialiasing = !antialiasing;
+
+		recalculate |= true;
+
+		return true;
+	}
+
+	bool ToggleResultBuffer(olc::Key)
+	{
+		useResultBuffer = !useResultBuffer;
+
 		recalculate |= true;
 
 		return true;
@@ -620,6 +1543,15 @@ public:
 		return true;
 	}
 
+	bool ToggleSymmetry(olc::Key)
+	{
+		useSymmetry = !useSymmetry;
+
+		recalculate |= true;
+
+		return true;
+	}
+
 	bool ExitProgram(olc::Key)
 	{
 		return false;
@@ -670,8 +1602,61 @@ public:
 		return true;
 	}
 
+	// The lines of text shown at the top left
+	std::vector<std::string> BuildHud()
+	{
+		std::vector<std::string> hud;
+
+		// Parallelization method
+		hud.push_back(std::to_string(nMode + 1) + ") " + Methods[nMode].description
+					  + (julia ? " -- Julia set" : ""));
+
+		// Show compiler, and the instruction set of the kernels selected for this processor
+		hud.push_back("Compiler: " + buildCompilerString() + ", " + IsaName(SelectedIsa()) + " kernels");
+
+		// Calculation time
+		hud.push_back("Time Taken: " + std::to_string(elapsedTime.count()) + "s"
+					  + (loadedFromStore ? " (disk store)" : "")
+					  + (mirroredFraction > 0.0 ? " (" + std::to_string(int(100 * mirroredFraction)) + "% mirrored)" : "")
+					  + (diskFilling ? " (" + std::to_string(int(100 * diskFilledFraction)) + "% disk filled)" : ""));
+
+		if (useCounters)
+			hud.push_back("Counters: " + counters.Describe(double(ScreenWidth()) * ScreenHeight()));
+
+		if (antialiasing)
+		{
+			std::lock_guard<std::mutex> lock(aaMutex);
+			hud.push_back("Antialiased: " + std::to_string(aaPixels.size()) + " pixels ("
+						  + std::to_string(100.0 * aaPixels.size() / (double(ScreenWidth()) * ScreenHeight())) + "%), "
+						  + std::to_string(aaTime.count()) + "s");
+		}
+
+		// Current max iteration
+		hud.push_back("Iterations: " + std::to_string(m_pCurrentPointAlgorithm->maxIterations)
+					  + (resumedFrom ? " (resumed " + std::to_string(resumedPixels.load()) + " pixels from " + std::to_string(resumedFrom) + ")" : ""));
+
+		{
+			std::lock_guard<std::mutex> lock(statisticsMutex);
+			hud.push_back("Inside: " + std::to_string(int(100 * statistics.InteriorFraction())) + "%"
+						  + ", near limit: " + std::to_string(100 * statistics.UnresolvedFraction()) + "%"
+						  + ", proposed iterations " + std::to_string(proposedIterations) + ", scale " + std::to_string(int(proposedScale))
+						  + (autoIterations ? " (auto)" : ""));
+		}
+
+		// If there is an orbit track, display data
+		if (track.size() > 1)
+		{
+			hud.push_back("Track length: " + std::to_string(track.size()));
+			hud.push_back("Loop length: " + std::to_string(loopLength));
+		}
+
+		return hud;
+	}
+
 	bool OnUserUpdate(float fElapsedTime) override
 	{
+		TRACE_SCOPE("frame");
+
 		auto oldOffSet = tv.GetWorldOffset();
 		auto oldScale = tv.GetWorldScale();
 
@@ -694,6 +1679,12 @@ public:
 			}
 
 			guiIterationValue->sText = std::to_string(nIterations);
+
+			// Used from the next render
+			threadCount = int(guiThreadsSlider->fValue + 0.5f);
+			grainSize = int(guiGrainSlider->fValue + 0.5f);
+			if (guiScheduleButton->bPressed)
+				schedule = RenderSchedule((int(schedule) + 1) % 3);
 		}
 
 		// Handle User Input
@@ -715,6 +1706,7 @@ public:
 		{
 			if (GetKey(c.key).bPressed)
 			{
+				TRACE_SCOPE("key command");
 				if (!(this->*c.pKeyCommandFunction)(c.key))
 					return false;
 			}
@@ -730,10 +1722,15 @@ public:
 
 		if (recalculate)
 		{
+			TRACE_SCOPE("recalculate");
+
 			if (currentHelperThread)
 			{
+				TRACE_SCOPE("cancel and join");
+
 				// Stop the current calculation
 				stopCalculation = true;
+				TRACE_INSTANT("cancel");
 
 				currentHelperThread.get()->join();
 			}
@@ -741,7 +1738,20 @@ public:
 			// Safe area, where globals can be changed
 			stopCalculation = false;
 			calculationCompleted = false;
-			if (calculateConvergence)
+			resultsInUse = NeedsResultBuffer();
+			if (resultsInUse)
+			{
+				unsigned channels = RequiredChannels();
+				if (results.getWidth() != ScreenWidth() || results.getHeight() != ScreenHeight() || results.getChannels() != channels)
+					results.Allocate(ScreenWidth(), ScreenHeight(), channels);
+
+				ComputePointFull* pFull = new ComputePointFull;
+				pFull->channels = channels;
+				pFull->julia = julia;
+				m_pCurrentPointAlgorithm.reset(pFull);
+				packMode = CurrentInteriorMode();
+			}
+			else if (calculateConvergence)
 				m_pCurrentPointAlgorithm.reset(new ComputePointWithConvergence);
 			else if (loopCheck)
 				m_pCurrentPointAlgorithm.reset(new ComputePointWithLoop);
@@ -754,21 +1764,55 @@ public:
 			m_pCurrentPointAlgorithm->maxIterations = nIterations;
 			m_pCurrentPointAlgorithm->bailOutSquare = bailoutSquared;
 
+			currentPixelSize = std::abs(frac_br.x - frac_tl.x) / double(pix_br.x - pix_tl.x);
+
 			elapsedTime = std::chrono::duration<double>();
 
-			currentHelperThread.reset(new std::thread { &FractalFramework::ThreadFunction, this, pix_tl, pix_br, frac_tl, frac_br, nIterations });
+			currentKey = MakeRenderKey(pix_tl, pix_br, frac_tl, frac_br);
+			MarkAllRowsDirty();
+			ResetHistogram();
+			costs.Reset(pix_br.x - pix_tl.x, pix_br.y - pix_tl.y);
+			workerLoad.Reset();
+			{
+				// Don't show the supersamples of the previous view
+				std::lock_guard<std::mutex> lock(aaMutex);
+				aaPixels.clear();
+				aaValues.clear();
+				aaSmooth.clear();
+				aaResults.clear();
+			}
+
+			// The store only holds the packed values, not the result buffer,
+			// and the costs of a stored view are not known
+			loadedFromStore = !showCosts && !resultsInUse && !diskFilling && !antialiasing && tileStore.Read(currentKey, [this] (const int32_t* values, size_t count)
+				{
+					std::copy(values, values + count, pFractal);
+				});
+
+			resumedFrom = 0;
+
+			if (loadedFromStore)
+			{
+				// Already known, no calculation needed
+				currentHelperThread.reset();
+				GatherStatistics();
+				calculationCompleted = true;
+			}
+			else
+			{
+				currentHelperThread.reset(new std::thread { &FractalFramework::ThreadFunction, this, pix_tl, pix_br, frac_tl, frac_br, nIterations });
+			}
 			
 			recalculate = false;
 		}
 
+		UpdateProposals(pix_tl, pix_br, frac_tl, frac_br);
+		UpdateDashboard();
+
 		// Render result to screen
 		// effectiveColorizer->scale = nIterations;
-		IColorizer * effectiveColorizer = basicColorizer;
-		if (striped)
-		{
-			stripedColorizer.setCore(effectiveColorizer);
-			effectiveColorizer = &stripedColorizer;
-		}
+		if (histogramColoring)
+			UpdateHistogram();
 
 		if (shifting)
 		{
@@ -778,32 +1822,74 @@ public:
 				shiftColorizer.setShift(shiftColorizer.getShift()+1);
 				shiftTime = fmodf(shiftTime, (1.0f / shiftSpeed));
 			}
+		}
+
+		IColorizer * effectiveColorizer = EffectiveColorizer();
+
+		const float* pSmooth = smoothColoring && resultsInUse && results.Has(ChannelSmooth) ? results.smooth.data() : nullptr;
+		const float* pDistance = distanceShading && resultsInUse && results.Has(ChannelDistance) ? results.distance.data() : nullptr;
+		const float pixelSize = float(currentPixelSize);
 
-			shiftColorizer.setCore(effectiveColorizer);
-			effectiveColorizer = &shiftColorizer;
+		ColorState colorState;
+		colorState.usePalette = usePalette;
+		colorState.ring = usePalette && shifting && !pSmooth && !pDistance && PaletteRing::CanRing(basicColorizer->getScale());
+		colorState.pSmooth = pSmooth;
+		colorState.pDistance = pDistance;
+		colorState.pixelSize = pixelSize;
+		{
+			std::lock_guard<std::mutex> lock(aaMutex);
+			colorState.aaPixels = aaPixels.size();
 		}
 
-		int yOffset = 0;
-		for (int y = 0; y < ScreenHeight(); y++)
+		if (colorState.ring)
 		{
-			for (int x = 0; x < ScreenWidth(); x++)
-			{
-				int i = pFractal[yOffset + x];
-				if (i >= nIterations)
-				{
-					if (i == nIterations)
-						Draw(x, y, olc::BLACK);
-					else
-						Draw(x, y,
-							 effectiveColorizer->ColorizePixel(i-nIterations));
-				}
-				else
-				{
-					Draw(x, y,
-						effectiveColorizer->ColorizePixel(i));
-				}
-			}
-			yOffset += ScreenWidth();
+			// The ring holds the chain without the shifting decorator
+			PaletteSignature signature;
+			signature.basic = basicColorizer;
+			signature.striped = striped;
+			signature.histogramVersion = histogramColoring ? histogramColorizer.getVersion() : 0;
+			signature.scale = basicColorizer->getScale();
+			signature.maxIterations = nIterations;
+			ringIndexesStale |= paletteRing.Update(*shiftColorizer.getCore(), signature);
+
+			colorState.signature = signature;
+			colorState.signature.shift = shiftColorizer.getShift();
+		}
+		else
+		{
+			PaletteSignature signature;
+			signature.basic = basicColorizer;
+			signature.striped = striped;
+			signature.histogramVersion = histogramColoring ? histogramColorizer.getVersion() : 0;
+			signature.shifting = shifting;
+			signature.shift = shifting ? shiftColorizer.getShift() : 0;
+			signature.scale = basicColorizer->getScale();
+			signature.maxIterations = nIterations;
+			if (usePalette)
+				palette.Update(*effectiveColorizer, signature);
+
+			colorState.signature = signature;
+		}
+
+		// Color only the rows with new values, unless the colors changed
+		// When a calculation completes, everything is colored once more, as not all parts are calculated row by row
+		auto tpColor = std::chrono::high_resolution_clock::now();
+		const bool completed = calculationCompleted;
+		const std::vector<int> dataRows = TakeDirtyRows(completed && !wasCompleted);
+		const std::vector<int> rows = colorState != lastColorState ? TakeDirtyRows(true) : dataRows;
+		wasCompleted = completed;
+		lastColorState = colorState;
+
+		if (colorState.ring)
+			RotateRows(*effectiveColorizer, shiftColorizer.getShift(), dataRows, rows);
+		else
+			ColorizeRows(*effectiveColorizer, pSmooth, pDistance, pixelSize, rows);
+
+		if (!rows.empty())
+		{
+			// Send the layer to the GPU this frame
+			GetLayers()[fractalLayer].bUpdate = true;
+			colorTime = std::chrono::high_resolution_clock::now() - tpColor;
 		}
 
 		olc::vf2d pos = GetMousePos();
@@ -868,6 +1954,39 @@ public:
 			loopLength = 0;
 		}
 
+		// Nothing new to show, don't draw anything, and give the processor a rest
+		OverlayState overlayState;
+		overlayState.mouse = GetMousePos();
+		overlayState.trackLength = track.size();
+		overlayState.juliaSeed = juliaSeed;
+		overlayState.showGui = bShowGui;
+		overlayState.hud = BuildHud();
+		overlayState.showCosts = showCosts;
+		overlayState.costTotal = showCosts ? costs.TotalNanoseconds() : 0;
+		if (bShowGui)
+			ObserveGui(overlayState);
+
+		const bool redraw = firstFrame || overlayState != lastOverlayState;
+		firstFrame = false;
+		lastOverlayState = overlayState;
+
+		if (!redraw)
+		{
+			if (completed && rows.empty())
+				std::this_thread::sleep_for(std::chrono::milliseconds(idleSleep));
+
+			return !(GetKey(olc::Key::ESCAPE).bPressed);
+		}
+
+		// The overlays are drawn on a transparent layer 0
+		TRACE_SCOPE("overlays");
+		auto tpOverlay = std::chrono::high_resolution_clock::now();
+		SetDrawTarget(nullptr);
+		Clear(olc::BLANK);
+
+		if (showCosts)
+			DrawCosts(pix_tl);
+
 		if (track.size() > 1)
 		{
 			for (size_t i = 0; i < track.size() - 1; i++)
@@ -905,69 +2024,25 @@ public:
 		if (bShowGui)
 		{
 			guiManager.Draw(this);
+			DrawWorkerLoad({ 900, ScreenHeight() - 92 }, { 370, 56 });
 		}
 
 		uint32_t scale = 1;
 		int32_t lineDistance = 10;
 		int32_t lineNo = 0;
 
-		// Parallelization method
-		DrawString(0, lineNo++ * scale * lineDistance, std::to_string(nMode + 1) + ") " + Methods[nMode].description
-				   + (julia ? " -- Julia set" : ""), olc::WHITE, scale);
-
-		// Show compiler
-		DrawString(0, lineNo++ * scale * lineDistance, "Compiler: " + buildCompilerString(), olc::WHITE, scale);
-
-		// Calculation time
-		DrawString(0, lineNo++ * scale * lineDistance, "Time Taken: " + std::to_string(elapsedTime.count()) + "s", olc::WHITE, scale);
+		for (const auto& line : overlayState.hud)
+			DrawString(0, lineNo++ * scale * lineDistance, line, olc::WHITE, scale);
 
-		// Current max iteration
-		DrawString(0, lineNo++ * scale * lineDistance, "Iterations: " + std::to_string(m_pCurrentPointAlgorithm->maxIterations), olc::WHITE, scale);
-		
-		// If there is an orbit track, display data
-		if (track.size() > 1)
-		{
-			DrawString(0, lineNo++ * scale * lineDistance, "Track length: " + std::to_string(track.size()), olc::WHITE, scale);
-			DrawString(0, lineNo++ * scale * lineDistance, "Loop length: " + std::to_string(loopLength), olc::WHITE, scale);
-		}
+		// Not part of the overlay state, it would make every frame differ
+		DrawString(0, lineNo++ * scale * lineDistance, "Frame: colors " + std::to_string(colorTime.count() * 1000) + "ms, overlays "
+				   + std::to_string(overlayTime.count() * 1000) + "ms", olc::WHITE, scale);
+		overlayTime = std::chrono::high_resolution_clock::now() - tpOverlay;
 
 		// Exit program when returning false
 		return !(GetKey(olc::Key::ESCAPE).bPressed);
 	}
 
-	std::string buildCompilerString () const
-	{
-		std::string compiler = "Unknown";
-	#if defined(_MSC_VER)
-		#if defined(__clang_version__)
-			compiler = "Visual Studio clang ("  __clang_version__ ")";
-		#else
-			compiler = "MSVC";
-		#endif
-
-		#if !defined(NDEBUG)
-			compiler += " (debug build)";
-		#endif
-	#elif defined(__GNUG__)
-		#if defined(__MINGW64__)
-			compiler = "MinGW64";
-		#elif defined(__clang_version__)
-			compiler = "clang ("  __clang_version__ ")";
-		#else
-			compiler = "g++";
-		#endif
-	
-		#if !defined(__OPTIMIZE__)
-			compiler += " (debug build)";
-		#endif
-	#elif defined(__clang_version__)
-		compiler = "clang ("  __clang_version__ ")";
-	#endif
-
-		return compiler;
-	}
-
-
 	olc::TransformedViewD tv;
 
 	IColorizer* basicColorizer = nullptr;
@@ -976,6 +2051,7 @@ public:
 	StripedColorizer stripedColorizer;
 	ColorUp colorUpColorizer;
 	ShiftingColorizer shiftColorizer;
+	HistogramColorizer histogramColorizer;
 };
 
 const std::vector<FractalFramework::method_s> FractalFramework::Methods
@@ -983,23 +2059,23 @@ const std::vector<FractalFramework::method_s> FractalFramework::Methods
 {
 	{
 		olc::Key::K1,
-		&FractalFramework::CreateFractalOpenMP,
+		"openmp",
 		"OpenMP parallel for"
 	},
 	{
 		olc::Key::K2,
-		&FractalFramework::CreateFractalSingleThread,
+		"single",
 		"Single Thread Method"
 	},
 	{
 		olc::Key::K3,
-		&FractalFramework::CreateFractalCppForEachAlgorithm,
+		"cpp17",
 		"C++17 for_each_n parallel implementation"
 	},
 #if defined(_MSC_VER)
 	{
 		olc::Key::K4,
-		&FractalFramework::CreateFractalParallelization,
+		"ppl",
 		"MS parallel_for"
 	},
 #endif
@@ -1007,7 +2083,7 @@ const std::vector<FractalFramework::method_s> FractalFramework::Methods
 #if defined(__GNUG__)  || defined(USE_TBB_WITH_MSC)
 	{
 		olc::Key::K5,
-		&FractalFramework::CreateFractalTbbParallelization,
+		"tbb",
 		"oneTBB parallel_for"
 	},
 #endif
@@ -1094,6 +2170,76 @@ const std::vector<FractalFramework::key_command_s> FractalFramework::KeyCommands
 		"Toggle GUI",
 		&FractalFramework::ToggleGui
 	},
+	{
+		keyData(Y),
+		"Toggle symmetry exploitation",
+		&FractalFramework::ToggleSymmetry
+	},
+	{
+		keyData(F),
+		"Toggle smooth (fractional) escape count coloring",
+		&FractalFramework::ToggleSmoothColoring
+	},
+	{
+		keyData(D),
+		"Toggle distance estimate shading",
+		&FractalFramework::ToggleDistanceShading
+	},
+	{
+		keyData(E),
+		"Toggle distance estimate disk filling of exterior pixels",
+		&FractalFramework::ToggleDiskFilling
+	},
+	{
+		keyData(O),
+		"Toggle automatic iterations and color scale",
+		&FractalFramework::ToggleAutoIterations
+	},
+	{
+		keyData(N),
+		"Toggle histogram equalized colors",
+		&FractalFramework::ToggleHistogramColoring
+	},
+	{
+		keyData(K),
+		"Benchmark colorizers, output to console",
+		&FractalFramework::BenchmarkColorizers
+	},
+	{
+		keyData(V),
+		"Toggle palette lookup table",
+		&FractalFramework::TogglePalette
+	},
+	{
+		keyData(Z),
+		"Toggle adaptive antialiasing",
+		&FractalFramework::ToggleAntialiasing
+	},
+	{
+		keyData(X),
+		"Toggle result buffer (change interior mode without recalculation)",
+		&FractalFramework::ToggleResultBuffer
+	},
+	{
+		keyData(W),
+		"Toggle hardware performance counters (Linux perf events)",
+		&FractalFramework::ToggleCounters
+	},
+	{
+		keyData(H),
+		"Toggle cost heatmap of the calculation (SHIFT to export it to costmap.csv)",
+		&FractalFramework::ToggleCosts
+	},
+	{
+		keyData(T),
+		"Write a timeline of the last frames and calculations to trace.json (build with FRACTAL_TRACE)",
+		&FractalFramework::WriteTrace
+	},
+	{
+		keyData(P),
+		"Auto-tune method, threads, grain and schedule for this machine, kept in FractalFramework.tune",
+		&FractalFramework::AutoTune
+	},
 };
 
 int main()
@@ -0,0 +1,228 @@
+/*
+	Fractal Render, batch renderer for the Fractal Framework
+
+	Renders a single view without a window, with the render core and the
+	colorizers of the Fractal Framework, and writes it as PNG or raw values.
+	PixelGameEngine is only used for its pixel type, on its headless platform.
+
+	Usage, all options can be left out:
+		FractalRender --width 1280 --height 960 --center -0.5,0 --size 3
+					  --formula mandelbrot|burningship|logistic --julia x,y
+					  --iterations 256 --interior plain|loop|convergence|index
+					  --strategy openmp|single|cpp17|ppl|tbb --no-symmetry
+					  --colorizer eriksson|optimized|colorup --output image.png|values.raw
+					  --trace trace.json
+
+	Raw output is the packed int32 value of each pixel, row by row, in native byte order.
+	The trace is a Chrome trace of the render, only when built with FRACTAL_TRACE defined.
+*/
+
+#define OLC_PGE_HEADLESS
+#define OLC_PGE_APPLICATION
+#include "olcPixelGameEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#include "ErikssonColorizer.h"
+#include "OptimizedEriksson.h"
+#include "InterpolatingColorizer.h"
+
+#include "RenderCore.h"
+#include "PngWriter.h"
+
+struct RenderOptions
+{
+	int width = 1280;
+	int height = 960;
+	double centerx = -0.5, centery = 0.0;
+	double size = 3.0;				// World width of the view
+	std::string formula = "mandelbrot";
+	bool julia = false;
+	double seedx = 0.0, seedy = 0.0;
+	int iterations = 256;
+	std::string interior = "plain";
+	std::string strategy = "openmp";
+	bool symmetry = true;
+	std::string colorizer = "eriksson";
+	std::string output = "fractal.png";
+	std::string trace;				// Chrome trace of the render, when set
+};
+
+static void Usage()
+{
+	std::cerr << "Usage: FractalRender [--width W] [--height H] [--center X,Y] [--size WORLDWIDTH]" << std::endl
+			  << "                     [--formula mandelbrot|burningship|logistic] [--julia X,Y]" << std::endl
+			  << "                     [--iterations N] [--interior plain|loop|convergence|index]" << std::endl
+			  << "                     [--strategy openmp|single|cpp17|ppl|tbb] [--no-symmetry]" << std::endl
+			  << "                     [--colorizer eriksson|optimized|colorup] [--output FILE.png|FILE.raw]" << std::endl
+			  << "                     [--trace FILE.json]" << std::endl;
+}
+
+static bool ParsePair(const char* text, double& x, double& y)
+{
+	return std::sscanf(text, "%lf,%lf", &x, &y) == 2;
+}
+
+static bool ParseOptions(int argc, char* argv[], RenderOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (option == "--no-symmetry")
+		{
+			options.symmetry = false;
+			continue;
+		}
+
+		if (!value)
+			return false;
+		i++;
+
+		if (option == "--width")
+			options.width = std::atoi(value);
+		else if (option == "--height")
+			options.height = std::atoi(value);
+		else if (option == "--center")
+		{
+			if (!ParsePair(value, options.centerx, options.centery))
+				return false;
+		}
+		else if (option == "--size")
+			options.size = std::atof(value);
+		else if (option == "--formula")
+			options.formula = value;
+		else if (option == "--julia")
+		{
+			options.julia = true;
+			if (!ParsePair(value, options.seedx, options.seedy))
+				return false;
+		}
+		else if (option == "--iterations")
+			options.iterations = std::atoi(value);
+		else if (option == "--interior")
+			options.interior = value;
+		else if (option == "--strategy")
+			options.strategy = value;
+		else if (option == "--colorizer")
+			options.colorizer = value;
+		else if (option == "--output")
+			options.output = value;
+		else if (option == "--trace")
+			options.trace = value;
+		else
+			return false;
+	}
+
+	return options.width > 0 && options.height > 0 && options.iterations > 0 && options.size > 0;
+}
+
+int main(int argc, char* argv[])
+{
+	RenderOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		Usage();
+		return 1;
+	}
+
+	// Formula, with its start value and bailout, as selected by M, B and G in the framework
+	FormulaDefaults defaults;
+	std::unique_ptr<IComputeState> state(CreateComputeState(options.formula, defaults));
+	std::unique_ptr<IComputePoint> point(CreateComputePoint(options.interior));
+	const int backend = RenderEngine::FindBackend(options.strategy);
+	const bool colorizerKnown = options.colorizer == "eriksson" || options.colorizer == "optimized" || options.colorizer == "colorup";
+	if (!state || !point || backend < 0 || !colorizerKnown)
+	{
+		Usage();
+		return 1;
+	}
+	point->z.reset(state->Clone());
+	point->maxIterations = options.iterations;
+	point->bailOutSquare = defaults.bailoutSquare;
+
+	RenderView view = CenteredView(options.width, options.height, options.centerx, options.centery, options.size);
+	view.julia = options.julia;
+	view.seedr = options.seedx;
+	view.seedi = options.seedy;
+	view.z0r = defaults.z0r;
+	view.z0i = defaults.z0i;
+
+	RenderSettings settings;
+	settings.backend = size_t(backend);
+	settings.useSymmetry = options.symmetry;
+
+	std::vector<int> values(size_t(view.width) * view.height);
+	RenderTarget target;
+	target.values = values.data();
+
+	auto tp1 = std::chrono::high_resolution_clock::now();
+
+	RenderEngine(view, settings, *point, target).Render();
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - tp1;
+
+	const uint64_t iterations = NominalIterations(values.data(), values.size(), options.iterations);
+
+	std::cout << view.width << "x" << view.height << " " << options.formula << (options.julia ? " julia" : "")
+			  << " " << options.interior << " " << options.strategy << ", " << IsaName(SelectedIsa()) << " kernels" << std::endl;
+	std::cout << "Wall time: " << elapsed.count() << " s" << std::endl;
+	std::cout << "Iterations: " << iterations << ", " << iterations / elapsed.count() / 1e9 << " Giterations/s" << std::endl;
+	std::cout << "Pixels: " << values.size() / elapsed.count() / 1e6 << " Mpixels/s" << std::endl;
+
+	if (!options.trace.empty() && !Trace::Write(options.trace))
+		std::cerr << "Could not write " << options.trace << (Trace::enabled ? "" : ", tracing needs a build with FRACTAL_TRACE defined") << std::endl;
+
+	const std::string& output = options.output;
+	if (output.size() >= 4 && output.compare(output.size() - 4, 4, ".raw") == 0)
+	{
+		std::ofstream file(output, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int));
+		if (!file)
+		{
+			std::cerr << "Could not write " << output << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	ErikssonColorizer eColorizer;
+	OptimizedErikssonColorizer oeColorizer;
+	ColorUp colorUpColorizer;
+	eColorizer.setScale((float) options.iterations);
+	oeColorizer.setScale((float) options.iterations);
+	colorUpColorizer.fromColor = olc::RED;
+	colorUpColorizer.toColor = olc::GREEN;
+	colorUpColorizer.fromValue = 1;
+	colorUpColorizer.toValue = 256;
+
+	IColorizer* colorizer = &eColorizer;		// Eriksson, the default
+	if (options.colorizer == "optimized")
+		colorizer = &oeColorizer;
+	else if (options.colorizer == "colorup")
+		colorizer = &colorUpColorizer;
+
+	// As the framework, black inside, or the inside value when there is one
+	std::vector<olc::Pixel> pixels(values.size());
+	colorizer->ColorizeSpan(values.data(), pixels.data(), values.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (values[i] == options.iterations)
+			pixels[i] = olc::BLACK;
+		else if (values[i] > options.iterations)
+			pixels[i] = colorizer->ColorizePixel(values[i] - options.iterations);
+	}
+
+	if (!PngWriter::Write(output, pixels.data(), view.width, view.height))
+	{
+		std::cerr << "Could not write " << output << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+// Golden images: reference counts of canonical scenes, to check the optimized engines against
+//
+// The reference is the plain scalar calculation, ComputePointCount() of the ComputePoint*
+// classes for every pixel, in one thread, with nothing mirrored, filled or resumed.
+// Golden files keep the reference counts with a checksum, so a change of the scalar
+// classes themselves shows up as well. Differences can be written as heatmaps.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "RenderCore.h"
+
+// Every pixel of the plan calculated, including those the plan would mirror
+// Those are calculated at the reflection of the point they are mirrored from, exact for a center of zero,
+// as stepping from the snapped corner to them rounds differently
+inline std::vector<int> RenderReference(const RenderView& view, const RenderPlan& plan, IComputePoint& prototype)
+{
+	std::vector<int> values(size_t(view.width) * view.height);
+	std::unique_ptr<IComputePoint> point(prototype.Clone());
+	const SymmetryInfo info = prototype.z->GetSymmetry(view.julia, view.z0r, view.z0i);
+	const RenderRect& mirror = plan.mirror;
+
+	for (int y = 0; y < view.height; y++)
+	{
+		for (int x = 0; x < view.width; x++)
+		{
+			const bool mirrored = plan.symmetry != Symmetry::Asymmetric && x >= mirror.x0 && x < mirror.x1 && y >= mirror.y0 && y < mirror.y1;
+			double x_pos = plan.tlx + x * plan.x_scale;
+			double y_pos = plan.tly + y * plan.y_scale;
+			if (mirrored)
+			{
+				y_pos = 2.0 * info.centeri - (plan.tly + (plan.ky - y) * plan.y_scale);
+				if (plan.symmetry == Symmetry::Point)
+					x_pos = 2.0 * info.centerr - (plan.tlx + (plan.kx - x) * plan.x_scale);
+			}
+
+			if (view.julia)
+				values[size_t(y) * view.width + x] = point->ComputePointCount(view.seedr, view.seedi, x_pos, y_pos);
+			else
+				values[size_t(y) * view.width + x] = point->ComputePointCount(x_pos, y_pos, view.z0r, view.z0i);
+		}
+	}
+
+	return values;
+}
+
+// FNV-1a over the values
+inline uint32_t GoldenChecksum(const std::vector<int>& values)
+{
+	uint32_t h = 2166136261u;
+	const uint8_t* b = reinterpret_cast<const uint8_t*>(values.data());
+	for (size_t i = 0; i < values.size() * sizeof(int); i++)
+		h = (h ^ b[i]) * 16777619u;
+	return h;
+}
+
+// How far an engine may differ from the reference
+struct GoldenTolerance
+{
+	double mismatchFraction = 0.0;	// Of the pixels, allowed to differ at all
+	double meanDifference = 0.0;	// Of the counts, averaged over all pixels
+};
+
+struct GoldenDiff
+{
+	size_t pixels = 0;
+	size_t mismatches = 0;
+	int maxDifference = 0;
+	double meanDifference = 0.0;
+
+	double MismatchFraction() const { return pixels ? double(mismatches) / pixels : 0.0; }
+
+	bool Within(const GoldenTolerance& tolerance) const
+	{
+		return MismatchFraction() <= tolerance.mismatchFraction && meanDifference <= tolerance.meanDifference;
+	}
+};
+
+inline GoldenDiff CompareToReference(const std::vector<int>& reference, const int* values)
+{
+	GoldenDiff diff;
+	double sum = 0.0;
+
+	diff.pixels = reference.size();
+	for (size_t i = 0; i < reference.size(); i++)
+	{
+		const int d = std::abs(values[i] - reference[i]);
+		if (d)
+		{
+			diff.mismatches++;
+			diff.maxDifference = std::max(diff.maxDifference, d);
+			sum += d;
+		}
+	}
+	diff.meanDifference = diff.pixels ? sum / diff.pixels : 0.0;
+
+	return diff;
+}
+
+// Binary PPM of the reference in gray, with the differing pixels in red, brighter for larger differences
+inline bool WriteHeatmap(const std::string& path, const std::vector<int>& reference, const int* values, int width, int height)
+{
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	const int maxValue = std::max(1, *std::max_element(reference.begin(), reference.end()));
+	int maxDifference = 1;
+	for (size_t i = 0; i < reference.size(); i++)
+		maxDifference = std::max(maxDifference, std::abs(values[i] - reference[i]));
+
+	std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+	std::vector<uint8_t> rgb(reference.size() * 3);
+	for (size_t i = 0; i < reference.size(); i++)
+	{
+		const int d = std::abs(values[i] - reference[i]);
+		if (d)
+		{
+			rgb[i * 3 + 0] = uint8_t(128 + 127 * d / maxDifference);
+			rgb[i * 3 + 1] = 0;
+			rgb[i * 3 + 2] = 0;
+		}
+		else
+		{
+			const uint8_t gray = uint8_t(80 * std::min(reference[i], maxValue) / maxValue);
+			rgb[i * 3 + 0] = rgb[i * 3 + 1] = rgb[i * 3 + 2] = gray;
+		}
+	}
+	bool ok = std::fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+
+	return std::fclose(file) == 0 && ok;
+}
+
+// The stored references, counts as 16 bits when they fit, in native byte order
+class GoldenFile
+{
+public:
+	struct Entry
+	{
+		std::string name;
+		int width = 0, height = 0;
+		uint32_t checksum = 0;
+		std::vector<int> values;
+	};
+
+	std::vector<Entry> entries;
+
+	const Entry* Find(const std::string& name) const
+	{
+		for (const auto& e : entries)
+		{
+			if (e.name == name)
+				return &e;
+		}
+		return nullptr;
+	}
+
+	bool Save(const std::string& path) const
+	{
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool ok = std::fwrite(fileMagic, 1, sizeof(fileMagic), file) == sizeof(fileMagic);
+		ok = ok && Put(file, uint32_t(entries.size()));
+		for (const auto& e : entries)
+		{
+			char name[nameSize] = {};
+			std::strncpy(name, e.name.c_str(), nameSize - 1);
+			const bool narrow = std::all_of(e.values.begin(), e.values.end(), [] (int v) { return v >= 0 && v <= 0xFFFF; });
+
+			ok = ok && std::fwrite(name, 1, nameSize, file) == nameSize;
+			ok = ok && Put(file, uint32_t(e.width)) && Put(file, uint32_t(e.height)) && Put(file, e.checksum) && Put(file, uint32_t(narrow));
+			if (narrow)
+			{
+				std::vector<uint16_t> packed(e.values.begin(), e.values.end());
+				ok = ok && std::fwrite(packed.data(), sizeof(uint16_t), packed.size(), file) == packed.size();
+			}
+			else
+			{
+				ok = ok && std::fwrite(e.values.data(), sizeof(int), e.values.size(), file) == e.values.size();
+			}
+		}
+
+		return std::fclose(file) == 0 && ok;
+	}
+
+	bool Load(const std::string& path)
+	{
+		entries.clear();
+
+		FILE* file = std::fopen(path.c_str(), "rb");
+		if (!file)
+			return false;
+
+		char magic[sizeof(fileMagic)];
+		uint32_t count = 0;
+		bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::memcmp(magic, fileMagic, sizeof(magic)) == 0;
+		ok = ok && Get(file, count);
+		for (uint32_t i = 0; ok && i < count; i++)
+		{
+			Entry e;
+			char name[nameSize];
+			uint32_t width = 0, height = 0, narrow = 0;
+			ok = std::fread(name, 1, nameSize, file) == nameSize;
+			ok = ok && Get(file, width) && Get(file, height) && Get(file, e.checksum) && Get(file, narrow);
+			ok = ok && width <= 16384 && height <= 16384;
+			if (!ok)
+				break;
+
+			name[nameSize - 1] = 0;
+			e.name = name;
+			e.width = int(width);
+			e.height = int(height);
+			e.values.resize(size_t(width) * height);
+			if (narrow)
+			{
+				std::vector<uint16_t> packed(e.values.size());
+				ok = std::fread(packed.data(), sizeof(uint16_t), packed.size(), file) == packed.size();
+				std::copy(packed.begin(), packed.end(), e.values.begin());
+			}
+			else
+			{
+				ok = std::fread(e.values.data(), sizeof(int), e.values.size(), file) == e.values.size();
+			}
+			entries.push_back(std::move(e));
+		}
+
+		std::fclose(file);
+		if (!ok)
+			entries.clear();
+		return ok;
+	}
+
+private:
+	static constexpr char fileMagic[8] = { 'F', 'F', 'G', 'O', 'L', 'D', '0', '1' };
+	static const size_t nameSize = 48;
+
+	static bool Put(FILE* file, uint32_t value) { return std::fwrite(&value, sizeof(value), 1, file) == 1; }
+	static bool Get(FILE* file, uint32_t& value) { return std::fread(&value, sizeof(value), 1, file) == 1; }
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "IColorizer.h"
+
+// Pixels next to each other in the value buffer, counted in one go
+struct HistogramSpan
+{
+	size_t offset;
+	int length;
+};
+
+// Histogram equalization of the escape counts
+// Each count is mapped through the cumulative distribution of the counts in the view,
+// so the colors of the core are spread evenly over the pixels, whatever the zoom
+class HistogramColorizer : public ColorizerDecorator
+{
+public:
+	HistogramColorizer(IColorizer* pCore) : ColorizerDecorator(pCore) {}
+
+	// Start over, for counts from 0 to maxIterations - 1
+	void Reset(int maxIterations_)
+	{
+		maxIterations = maxIterations_;
+		counts.assign(maxIterations, 0);
+		cdf.assign(maxIterations + 1, 0.0f);
+		counted = 0;
+		version++;
+	}
+
+	// Count the escape values of the spans, with a histogram per thread merged at the end
+	void Add(const int* values, const std::vector<HistogramSpan>& spans)
+	{
+		if (spans.empty())
+			return;
+
+		const int count = int(spans.size());
+		size_t pixels = 0;
+
+#pragma omp parallel reduction(+ : pixels)
+		{
+			std::vector<uint64_t> local(maxIterations, 0);
+
+			int s;
+#pragma omp for schedule(dynamic, 16) nowait
+			for (s = 0; s < count; s++)
+			{
+				const int* p = values + spans[s].offset;
+				for (int x = 0; x < spans[s].length; x++)
+				{
+					if ((unsigned)p[x] < (unsigned)maxIterations)
+						local[p[x]]++;
+				}
+				pixels += spans[s].length;
+			}
+
+#pragma omp critical
+			for (int i = 0; i < maxIterations; i++)
+				counts[i] += local[i];
+		}
+
+		counted += pixels;
+		UpdateCdf();
+	}
+
+	// All n values at once, from scratch
+	void Build(const int* values, size_t n)
+	{
+		Reset(maxIterations);
+
+		std::vector<HistogramSpan> spans;
+		const int chunk = 4096;
+		for (size_t offset = 0; offset < n; offset += chunk)
+			spans.push_back({ offset, int(std::min(n - offset, size_t(chunk))) });
+
+		Add(values, spans);
+	}
+
+	// Number of pixels counted so far, escaped or not
+	size_t getCounted() const { return counted; }
+
+	// Changes each time the mapping changes
+	unsigned getVersion() const { return version; }
+
+	olc::Pixel ColorizePixel(int value) const override
+	{
+		return pCore->ColorizePixel(Equalize(float(value)));
+	}
+
+	olc::Pixel ColorizePixel(float value) const override
+	{
+		return pCore->ColorizePixel(Equalize(value));
+	}
+
+	void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override
+	{
+		float equalized[chunkSize];
+		for (size_t begin = 0; begin < n; begin += chunkSize)
+		{
+			const size_t count = std::min(n - begin, size_t(chunkSize));
+			for (size_t i = 0; i < count; i++)
+				equalized[i] = Equalize(float(values[begin + i]));
+			pCore->ColorizeSpan(equalized, out + begin, count);
+		}
+	}
+
+	void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override
+	{
+		float equalized[chunkSize];
+		for (size_t begin = 0; begin < n; begin += chunkSize)
+		{
+			const size_t count = std::min(n - begin, size_t(chunkSize));
+			for (size_t i = 0; i < count; i++)
+				equalized[i] = Equalize(values[begin + i]);
+			pCore->ColorizeSpan(equalized, out + begin, count);
+		}
+	}
+
+private:
+	// cdf[k] is the fraction of escaped pixels with a count below k
+	void UpdateCdf()
+	{
+		uint64_t total = 0;
+		for (int i = 0; i < maxIterations; i++)
+			total += counts[i];
+
+		uint64_t sum = 0;
+		cdf[0] = 0.0f;
+		for (int i = 0; i < maxIterations; i++)
+		{
+			sum += counts[i];
+			cdf[i + 1] = total ? float(double(sum) / double(total)) : 0.0f;
+		}
+
+		version++;
+	}
+
+	// Position in the scale of the core, interpolated for smooth values
+	float Equalize(float value) const
+	{
+		if (maxIterations == 0)
+			return value;
+
+		const float clamped = std::min(std::max(value, 0.0f), float(maxIterations));
+		const int k = std::min(int(clamped), maxIterations - 1);
+		const float fraction = clamped - k;
+
+		return (cdf[k] + fraction * (cdf[k + 1] - cdf[k])) * pCore->getScale();
+	}
+
+	static const int chunkSize = 256;
+
+	int maxIterations = 0;
+	std::vector<uint64_t> counts;
+	std::vector<float> cdf;
+	size_t counted = 0;
+	unsigned version = 0;
+};
@@ -7,6 +7,19 @@ class IColorizer
 public:
 	virtual olc::Pixel ColorizePixel(int value) const = 0;
 	virtual olc::Pixel ColorizePixel(float value) const = 0;
+
+	// Colorize n values at once, colorizers may override these with vectorized versions
+	virtual void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const
+	{
+		for (size_t i = 0; i < n; i++)
+			out[i] = ColorizePixel(values[i]);
+	}
+	virtual void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const
+	{
+		for (size_t i = 0; i < n; i++)
+			out[i] = ColorizePixel(values[i]);
+	}
+
 	virtual void setScale(float scale) = 0;
 	virtual float getScale() const = 0;
 
@@ -44,6 +57,10 @@ public:
 	virtual olc::Pixel ColorizePixel(int value) const override { return pCore->ColorizePixel(value); }
 	virtual olc::Pixel ColorizePixel(float value) const override { return pCore->ColorizePixel(value); }
 
+	// Decorators transform the span, and leave the colors to the span of the core
+	virtual void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override { pCore->ColorizeSpan(values, out, n); }
+	virtual void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override { pCore->ColorizeSpan(values, out, n); }
+
 	void setScale(float scale) override { pCore->setScale(scale); }
 	float getScale() const override { return pCore->getScale(); }
 
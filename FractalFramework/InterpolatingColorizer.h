@@ -1,5 +1,6 @@
 #pragma once
 #include "IColorizer.h"
+#include "ColorizerSimd.h"
 
 class ColorUp : public Colorizer
 {
@@ -28,6 +29,58 @@ public:
 		}
 	}
 
+#if defined(COLORIZER_SIMD)
+	void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override { Span(values, out, n); }
+	void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override { Span(values, out, n); }
+#endif
+
 private:
+#if defined(COLORIZER_SIMD)
+	// Lerp of the channels, truncated and added like the olc::Pixel operators
+	template <typename T>
+	void Span(const T* values, olc::Pixel* out, size_t n) const
+	{
+		using namespace ColorizerSimd;
+
+		const __m128 from = _mm_set1_ps(fromValue);
+		const __m128 to = _mm_set1_ps(toValue);
+		const __m128 range = _mm_set1_ps(toValue - fromValue);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128i channelMax = _mm_set1_epi32(255);
+		const __m128i fromPixels = _mm_set1_epi32(int(fromColor.n));
+		const __m128i toPixels = _mm_set1_epi32(int(toColor.n));
+		const __m128i alpha = _mm_set1_epi32(int(uint32_t(fromColor.a) << 24));
 
+		auto channel = [&] (float c0, float c1, __m128 s, __m128 t)
+			{
+				const __m128 full = _mm_set1_ps(255.0f);
+				__m128i a = _mm_cvttps_epi32(_mm_min_ps(full, _mm_max_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_set1_ps(c0), s))));
+				__m128i b = _mm_cvttps_epi32(_mm_min_ps(full, _mm_max_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_set1_ps(c1), t))));
+				__m128i sum = _mm_add_epi32(a, b);
+				__m128i over = _mm_cmpgt_epi32(sum, channelMax);
+				return Select(over, channelMax, sum);
+			};
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 value = Load(values + i);
+			__m128 t = _mm_div_ps(_mm_sub_ps(value, from), range);
+			__m128 s = _mm_sub_ps(one, t);
+
+			__m128i r = channel(fromColor.r, toColor.r, s, t);
+			__m128i g = channel(fromColor.g, toColor.g, s, t);
+			__m128i b = channel(fromColor.b, toColor.b, s, t);
+			__m128i lerp = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+
+			__m128i below = _mm_castps_si128(_mm_cmple_ps(value, from));
+			__m128i above = _mm_castps_si128(_mm_cmpge_ps(value, to));
+			__m128i result = Select(above, toPixels, lerp);
+			result = Select(below, fromPixels, result);
+			_mm_storeu_si128((__m128i*)(out + i), result);
+		}
+		for (; i < n; i++)
+			out[i] = ColorizePixel(values[i]);
+	}
+#endif
 };
\ No newline at end of file
@@ -1,24 +1,76 @@
 #pragma once
+#include <memory>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
 
 const double loopEpsilon = 1e-09;
 
+// The distance estimate is only reliable far outside the usual bailout,
+// so escaped points continue until this, without changing their count
+const double distanceBailOutSquare = 1e12;
+
+// Symmetry of the calculated set, which allows calculating just one half of a view
+enum class Symmetry
+{
+	Asymmetric,
+	RealAxis,	// Mirrored in the horizontal line through center
+	Point		// Mirrored through the center point
+};
+
+struct SymmetryInfo
+{
+	Symmetry symmetry = Symmetry::Asymmetric;
+	double centerr = 0.0, centeri = 0.0;
+};
+
 struct IComputeState
 {
 	double cr, ci;
 	double zr, zi;
 	double zr2, zi2;
 
+	// Derivative of z, with respect to c, or to z0 for julia sets
+	double dzr = 0.0, dzi = 0.0;
+	double dc = 1.0;	// dc/dc, 0 for julia sets
+
 	virtual void Initialize(double constX, double constY, double initX, double initY)
 	{
 		cr = constX; ci = constY;
 		zr = initX; zi = initY;
 		zr2 = zr * zr; zi2 = zi * zi;
 	}
+	// Call after Initialize(), before using AdvanceWithDerivative()
+	void InitializeDerivative(bool julia)
+	{
+		dc = julia ? 0.0 : 1.0;
+		dzr = julia ? 1.0 : 0.0;
+		dzi = 0.0;
+	}
 	virtual void Advance() = 0;
+	// Advance z and its derivative in one step
+	virtual void AdvanceWithDerivative() = 0;
 	virtual IComputeState* Clone() = 0;
+	virtual const char* Name() const = 0;
+	// The symmetry of the set, for julia sets or for a given z0
+	virtual SymmetryInfo GetSymmetry(bool /* julia */, double /* initr */, double /* initi */) const { return SymmetryInfo(); }
 	virtual ~IComputeState() { }
 };
 
+// Everything known about a point after the calculation, as opposed to the
+// single int from ComputePointCount(), where the meanings are merged
+struct PointResult
+{
+	int count = 0;				// Escape count, maxIterations if it did not escape
+	float magnitude2 = 0.0f;	// Final zr*zr + zi*zi
+	int period = 0;				// Loop length, 0 if no loop was found
+	int convergence = 0;		// Iterations before the loop was found
+	bool looped = false;		// A loop was found, so the ComputePoint* variants checking loops stopped there
+	int index = 0;				// Iteration where z came closest to the point
+	float smooth = 0.0f;		// Continuous escape count, for escaped points only
+	float distance = 0.0f;		// Exterior distance estimate, in world units, 0 for inside points
+};
+
 struct IComputePoint
 {
 	std::unique_ptr<IComputeState> z;
@@ -26,7 +78,14 @@ struct IComputePoint
 	double bailOutSquare = 4.0;
 
 	virtual int ComputePointCount(double x, double y, double initr = 0.0, double initi = 0.0) = 0;
+	// Only ComputePointFull fills in all of the result, the others just the count
+	virtual void ComputePointResult(double x, double y, double initr, double initi, PointResult& result)
+	{
+		result.count = ComputePointCount(x, y, initr, initi);
+		result.magnitude2 = float(z->zr2 + z->zi2);
+	}
 	virtual IComputePoint* Clone() = 0;
+	virtual const char* Name() const = 0;
 	virtual ~IComputePoint() { }
 };
 
@@ -46,12 +105,40 @@ struct MandelComputeState : public IComputeState
 		zi2 = zi * zi;
 	}
 
+	// dz = 2*z*dz + dc
+	inline void AdvanceWithDerivative() override
+	{
+		double ndzr = 2.0 * (zr * dzr - zi * dzi) + dc;
+		dzi = 2.0 * (zr * dzi + zi * dzr);
+		dzr = ndzr;
+
+		zi = zr * zi * 2.0 + ci;
+		zr = zr2 - zi2 + cr;
+
+		zr2 = zr * zr;
+		zi2 = zi * zi;
+	}
+
 	inline IComputeState* Clone() override
 	{
 		MandelComputeState* pR = new MandelComputeState(*this);
 
 		return pR;
 	}
+
+	inline const char* Name() const override { return "Mandelbrot"; }
+
+	// Julia sets: z and -z give the same z*z
+	// Mandelbrot set: With a real z0, conjugate c gives a conjugate orbit
+	inline SymmetryInfo GetSymmetry(bool julia, double /* initr */, double initi) const override
+	{
+		SymmetryInfo s;
+		if (julia)
+			s.symmetry = Symmetry::Point;
+		else if (initi == 0.0)
+			s.symmetry = Symmetry::RealAxis;
+		return s;
+	}
 };
 
 struct BurningShipComputeState : public IComputeState
@@ -72,12 +159,40 @@ struct BurningShipComputeState : public IComputeState
 		zi2 = zi * zi;
 	}
 
+	// As Mandelbrot, with the derivative of (|zr|, |zi|) being (sign(zr)*dzr, sign(zi)*dzi)
+	// dz = (2*zr*dzr - 2*zi*dzi + dc, 2*sign(zr*zi)*(zr*dzi + zi*dzr))
+	inline void AdvanceWithDerivative() override
+	{
+		double ndzr = 2.0 * (zr * dzr - zi * dzi) + dc;
+		double ndzi = 2.0 * (zr * dzi + zi * dzr);
+		dzi = (zr * zi < 0.0) ? -ndzi : ndzi;
+		dzr = ndzr;
+
+		zi = std::abs(zr * zi) * 2.0 + ci;
+		zr = zr2 - zi2 + cr;
+
+		zr2 = zr * zr;
+		zi2 = zi * zi;
+	}
+
 	inline IComputeState* Clone() override
 	{
 		BurningShipComputeState* pR = new BurningShipComputeState(*this);
 
 		return pR;
 	}
+
+	inline const char* Name() const override { return "BurningShip"; }
+
+	// Julia sets: Only the absolute values of zr and zi are used
+	// The ship itself is not symmetric, as the sign of ci is not removed
+	inline SymmetryInfo GetSymmetry(bool julia, double /* initr */, double /* initi */) const override
+	{
+		SymmetryInfo s;
+		if (julia)
+			s.symmetry = Symmetry::Point;
+		return s;
+	}
 };
 
 struct LogisticComputeState : public IComputeState
@@ -99,12 +214,44 @@ struct LogisticComputeState : public IComputeState
 		zi2 = zi * zi;
 	}
 
+	// With f = z*(1-z): dz = dc*f + c*(1-2z)*dz
+	inline void AdvanceWithDerivative() override
+	{
+		double fr = (zr - zr2 + zi2);
+		double fi = (zi - 2 * zr * zi);
+
+		// g = (1-2z)*dz
+		double gr = (1.0 - 2.0 * zr) * dzr + 2.0 * zi * dzi;
+		double gi = (1.0 - 2.0 * zr) * dzi - 2.0 * zi * dzr;
+		dzr = dc * fr + cr * gr - ci * gi;
+		dzi = dc * fi + ci * gr + cr * gi;
+
+		zr = cr * fr - ci * fi;
+		zi = ci * fr + cr * fi;
+
+		zr2 = zr * zr;
+		zi2 = zi * zi;
+	}
+
 	inline IComputeState* Clone() override
 	{
 		LogisticComputeState* pR = new LogisticComputeState(*this);
 
 		return pR;
 	}
+
+	inline const char* Name() const override { return "Logistic"; }
+
+	// Parameter plane: With a real z0, conjugate c gives a conjugate orbit
+	// Julia sets: z and 1-z give the same z*(1-z), but the bailout test on z0 itself
+	// is around 0, not 0.5, so the counts are not symmetric
+	inline SymmetryInfo GetSymmetry(bool julia, double /* initr */, double initi) const override
+	{
+		SymmetryInfo s;
+		if (!julia && initi == 0.0)
+			s.symmetry = Symmetry::RealAxis;
+		return s;
+	}
 };
 
 struct ComputePoint : public IComputePoint
@@ -137,6 +284,8 @@ struct ComputePoint : public IComputePoint
 		return pR;
 	}
 
+	inline const char* Name() const override { return "Escape"; }
+
 	~ComputePoint() override
 	{
 	}
@@ -201,6 +350,8 @@ struct ComputePointWithLoop : public IComputePoint
 		return pR;
 	}
 
+	inline const char* Name() const override { return "Loop"; }
+
 	~ComputePointWithLoop() override
 	{
 	}
@@ -258,6 +409,8 @@ struct ComputePointWithConvergence : public IComputePoint
 		return pR;
 	}
 
+	inline const char* Name() const override { return "Convergence"; }
+
 	~ComputePointWithConvergence() override
 	{
 	}
@@ -320,7 +473,153 @@ struct ComputePointWithIndex : public IComputePoint
 		return pR;
 	}
 
+	inline const char* Name() const override { return "Index"; }
+
 	~ComputePointWithIndex() override
 	{ }
 };
 
+// Bits for the parts of PointResult to calculate and keep
+enum ResultChannel : unsigned
+{
+	ChannelCount = 0x01,
+	ChannelMagnitude2 = 0x02,
+	ChannelPeriod = 0x04,
+	ChannelConvergence = 0x08,
+	ChannelIndex = 0x10,
+	ChannelSmooth = 0x20,
+	ChannelDistance = 0x40,
+	ChannelLooped = 0x80,
+};
+
+// Calculates all the requested channels in one pass,
+// so the different interior modes can be shown without recalculation
+struct ComputePointFull : public IComputePoint
+{
+	unsigned channels = ChannelCount | ChannelMagnitude2;
+	bool julia = false;		// Derivative with respect to z0 instead of c
+
+	inline int ComputePointCount(double x, double y, double initr = 0.0, double initi = 0.0) override
+	{
+		PointResult result;
+		ComputePointResult(x, y, initr, initi, result);
+		return result.count;
+	}
+
+	// Iterates to the escape or the limit, as ComputePoint, also when a loop is found, so the count is that of
+	// the plain mode. The loop channels keep what the variants checking loops had when they stopped at the loop
+	inline void ComputePointResult(double x, double y, double initr, double initi, PointResult& result) override
+	{
+		const bool checkLoops = (channels & (ChannelPeriod | ChannelConvergence | ChannelIndex | ChannelLooped)) != 0;
+		const bool trackIndex = (channels & ChannelIndex) != 0;
+		const bool trackDerivative = (channels & ChannelDistance) != 0;
+
+		int n = 0;
+		int index = 0;
+		int loopFound = 0;		// Iterations when the loop was found, 0 without
+		double distance2 = 2 * bailOutSquare;
+
+		z->Initialize(x, y, initr, initi);
+		z->InitializeDerivative(julia);
+
+		std::unique_ptr<IComputeState> ztail;
+		if (checkLoops)
+			ztail.reset(z->Clone());
+
+		while ((z->zr2 + z->zi2) < bailOutSquare && n < maxIterations)
+		{
+			if (trackDerivative)
+				z->AdvanceWithDerivative();
+			else
+				z->Advance();
+
+			bool loops = false;
+			if (checkLoops && !loopFound)
+			{
+				if (n & 0x1)
+					ztail->Advance();
+				loops = std::abs(z->zr - ztail->zr) < loopEpsilon && std::abs(z->zi - ztail->zi) < loopEpsilon;
+			}
+			n++;
+			if (trackIndex && n > 1 && !loopFound)
+			{
+				// Distance from z0
+				double newdistance2 = (z->zr - x) * (z->zr - x) + (z->zi - y) * (z->zi - y);
+				if (newdistance2 < distance2)
+				{
+					index = n - 1;
+					distance2 = newdistance2;
+				}
+			}
+			if (loops)
+			{
+				// The tail is not needed for finding loops anymore, it keeps z of here for the period
+				loopFound = n;
+				*ztail = *z;
+			}
+		}
+
+		const bool inside = n >= maxIterations;
+
+		result.count = inside ? maxIterations : n;
+		result.magnitude2 = float(z->zr2 + z->zi2);
+		result.looped = loopFound != 0;
+		result.convergence = loopFound / 2;
+		result.index = inside || loopFound ? index : 0;
+		result.period = 0;
+
+		if (!inside && (channels & ChannelSmooth))
+		{
+			// Normalized iteration count, only paid once, at escape
+			// Goes from n + 1 at |z| = bailout radius to n at the radius squared
+			double logRatio = std::log(z->zr2 + z->zi2) / std::log(bailOutSquare);
+			result.smooth = float(std::max(0.0, n + 1 - std::log2(logRatio)));
+		}
+
+		result.distance = 0.0f;
+		if (!inside && trackDerivative)
+		{
+			for (int extra = 0; (z->zr2 + z->zi2) < distanceBailOutSquare && extra < 64; extra++)
+				z->AdvanceWithDerivative();
+
+			// 2*|z|*log|z| / |dz|, a quarter of it is a lower bound for the distance to the set
+			double magnitude2 = z->zr2 + z->zi2;
+			double dz = std::sqrt(z->dzr * z->dzr + z->dzi * z->dzi);
+			result.distance = dz > 0.0 ? float(std::sqrt(magnitude2) * std::log(magnitude2) / dz) : 0.0f;
+		}
+
+		if (loopFound && (channels & ChannelPeriod))
+		{
+			// Calculate loop length from where it was found, as in ComputePointWithLoop
+			*z = *ztail;
+			z->Advance();
+			int loop = 1;
+			while (!(std::abs(z->zr - ztail->zr) < loopEpsilon && std::abs(z->zi - ztail->zi) < loopEpsilon) && loop < maxIterations)
+			{
+				z->Advance();
+				loop++;
+			}
+			result.period = loop;
+		}
+	}
+
+	inline IComputePoint* Clone() override
+	{
+		ComputePointFull* pR = new ComputePointFull();
+
+		assert(z);
+
+		pR->z.reset(z->Clone());
+		pR->maxIterations = maxIterations;
+		pR->bailOutSquare = bailOutSquare;
+		pR->channels = channels;
+		pR->julia = julia;
+
+		return pR;
+	}
+
+	inline const char* Name() const override { return "Full"; }
+
+	~ComputePointFull() override
+	{ }
+};
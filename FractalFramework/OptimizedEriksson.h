@@ -1,5 +1,6 @@
 #pragma once
 #include "IColorizer.h"
+#include "ColorizerSimd.h"
 #include <cmath>
 
 class OptimizedErikssonColorizer : public Colorizer
@@ -44,7 +45,53 @@ public:
 		return olc::PixelF(0.5f * red + 0.5f, 0.5f * green + 0.5f, 0.5f * blue + 0.5f);
 	}
 
+#if defined(COLORIZER_SIMD)
+	void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override { Span(values, out, n); }
+	void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override { Span(values, out, n); }
+#endif
+
 private:
+#if defined(COLORIZER_SIMD)
+	// The same steps as ColorizePixel(), four values at a time
+	template <typename T>
+	void Span(const T* values, olc::Pixel* out, size_t n) const
+	{
+		using namespace ColorizerSimd;
+
+		const __m128 scale = _mm_set1_ps(getScale());
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 twoPi = _mm_set1_ps(2 * pi);
+		const __m128 halfPi = _mm_set1_ps(pi / 2);
+		const __m128 threeHalfPi = _mm_set1_ps(3 * pi / 2);
+		const __m128 cosFactor = _mm_set1_ps(sqrt3half);
+		const __m128 sign = _mm_set1_ps(-0.0f);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 scaledAngle = _mm_div_ps(Load(values + i), scale);
+			scaledAngle = _mm_sub_ps(scaledAngle, Truncate(scaledAngle));
+			scaledAngle = _mm_add_ps(scaledAngle, _mm_and_ps(_mm_cmplt_ps(scaledAngle, zero), one));
+			scaledAngle = _mm_mul_ps(scaledAngle, twoPi);
+
+			__m128 sinx = Sin(scaledAngle);
+			__m128 cosx = _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(sinx, sinx)));
+			__m128 flip = _mm_and_ps(_mm_cmpgt_ps(scaledAngle, halfPi), _mm_cmplt_ps(scaledAngle, threeHalfPi));
+			cosx = _mm_xor_ps(cosx, _mm_and_ps(flip, sign));
+
+			__m128 sinpart = _mm_mul_ps(_mm_set1_ps(-0.5f), sinx);
+			__m128 cospart = _mm_mul_ps(cosFactor, cosx);
+			__m128 r = _mm_add_ps(_mm_mul_ps(half, sinx), half);
+			__m128 g = _mm_add_ps(_mm_mul_ps(half, _mm_add_ps(sinpart, cospart)), half);
+			__m128 b = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(sinpart, cospart)), half);
+			StorePixelF(out + i, r, g, b);
+		}
+		for (; i < n; i++)
+			out[i] = ColorizePixel(values[i]);
+	}
+#endif
 };
 
 const float OptimizedErikssonColorizer::pi = acos(-1.0f);
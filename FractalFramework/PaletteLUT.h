@@ -0,0 +1,179 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "IColorizer.h"
+
+// What a compiled palette depends on
+// The colorizers in the chain, their scale and the shift of a shifting decorator
+struct PaletteSignature
+{
+	const IColorizer* basic = nullptr;
+	bool striped = false;
+	bool shifting = false;
+	int shift = 0;
+	unsigned histogramVersion = 0;	// 0 without histogram equalization
+	float scale = 0;
+	int maxIterations = 0;
+
+	bool operator==(const PaletteSignature& other) const
+	{
+		return basic == other.basic && striped == other.striped && shifting == other.shifting
+			&& shift == other.shift && histogramVersion == other.histogramVersion && scale == other.scale && maxIterations == other.maxIterations;
+	}
+	bool operator!=(const PaletteSignature& other) const { return !(*this == other); }
+};
+
+// A colorizer chain compiled into a table indexed by the packed iteration value
+// 0 .. maxIterations - 1 are escape counts, maxIterations is plain inside (black),
+// maxIterations + k is the inside value k, as loop period, convergence or index
+class PaletteLUT
+{
+public:
+	// Compile the chain, if anything it depends on has changed
+	// Returns true when the table was rebuilt
+	bool Update(const IColorizer& colorizer, const PaletteSignature& signature_)
+	{
+		if (valid && signature == signature_)
+			return false;
+
+		signature = signature_;
+		const int maxIterations = signature.maxIterations;
+		const int size = 2 * maxIterations + 1;
+		table.resize(size);
+
+		int i;
+#pragma omp parallel for schedule(static)
+		for (i = 0; i < size; i++)
+		{
+			if (i < maxIterations)
+				table[i] = colorizer.ColorizePixel(i);
+			else if (i == maxIterations)
+				table[i] = olc::BLACK;
+			else
+				table[i] = colorizer.ColorizePixel(i - maxIterations);
+		}
+
+		valid = true;
+		return true;
+	}
+
+	void Invalidate() { valid = false; }
+
+	// Values outside the table are rare inside values, colorize those directly
+	olc::Pixel Lookup(const IColorizer& colorizer, int value) const
+	{
+		if ((unsigned)value < (unsigned)table.size())
+			return table[value];
+
+		return colorizer.ColorizePixel(value - signature.maxIterations);
+	}
+
+	bool isValid() const { return valid; }
+	size_t getSize() const { return table.size(); }
+
+private:
+	PaletteSignature signature;
+	std::vector<olc::Pixel> table;
+	bool valid = false;
+};
+
+// The colors of a chain without its shifting decorator, as a ring of scale entries
+// Shifting the colors is then an offset into the ring, instead of colorizing again
+// The ring is stored twice, so index + shift never needs a modulo, followed by black
+class PaletteRing
+{
+public:
+	// A shift is only an offset, when the scale is a whole number
+	static bool CanRing(float scale)
+	{
+		return scale >= 1 && scale <= (1 << 24) && scale == float(int(scale));
+	}
+
+	// Compile the ring from the unshifted chain, if anything it depends on has changed
+	// Returns true when it was rebuilt, the indexes must then be made again
+	bool Update(const IColorizer& colorizer, const PaletteSignature& signature_)
+	{
+		if (valid && signature == signature_)
+			return false;
+
+		signature = signature_;
+		size = int(signature.scale);
+		ring.resize(2 * size_t(size) + 1);
+
+		int k;
+#pragma omp parallel for schedule(static)
+		for (k = 0; k < size; k++)
+		{
+			ring[k] = ring[k + size] = colorizer.ColorizePixel(k);
+		}
+		ring[2 * size] = olc::BLACK;
+
+		valid = true;
+		return true;
+	}
+
+	void Invalidate() { valid = false; }
+
+	// Position in the ring of each packed value, independent of the shift
+	void Index(const int* values, int* indexes, int n, int maxIterations) const
+	{
+		const int black = 2 * size;
+
+		int i;
+#pragma omp parallel for schedule(static)
+		for (i = 0; i < n; i++)
+		{
+			const int v = values[i];
+			if (v == maxIterations)
+				indexes[i] = black;
+			else
+				indexes[i] = (v < maxIterations ? v : v - maxIterations) % size;
+		}
+	}
+
+	// Colors of all pixels for a shift, one gather per pixel
+	// Black stays black, as black + shift is clamped to the black entry
+	void Rotate(const int* indexes, olc::Pixel* out, int n, int shift) const
+	{
+		const int black = 2 * size;
+		const olc::Pixel* pRing = ring.data();
+
+		const int chunk = 4096;
+		const int chunks = (n + chunk - 1) / chunk;
+
+		int c;
+#pragma omp parallel for schedule(static)
+		for (c = 0; c < chunks; c++)
+		{
+			int i = c * chunk;
+			const int end = std::min(n, i + chunk);
+#if defined(__AVX2__)
+			const __m256i vShift = _mm256_set1_epi32(shift);
+			const __m256i vBlack = _mm256_set1_epi32(black);
+			for (; i + 8 <= end; i += 8)
+			{
+				__m256i index = _mm256_loadu_si256((const __m256i*)(indexes + i));
+				index = _mm256_min_epi32(_mm256_add_epi32(index, vShift), vBlack);
+				__m256i colors = _mm256_i32gather_epi32((const int*)pRing, index, 4);
+				_mm256_storeu_si256((__m256i*)(out + i), colors);
+			}
+#endif
+			for (; i < end; i++)
+			{
+				out[i] = pRing[std::min(indexes[i] + shift, black)];
+			}
+		}
+	}
+
+	bool isValid() const { return valid; }
+
+private:
+	PaletteSignature signature;
+	std::vector<olc::Pixel> ring;
+	int size = 0;
+	bool valid = false;
+};
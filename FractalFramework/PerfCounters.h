@@ -0,0 +1,273 @@
+#pragma once
+
+// Hardware performance counters of the calculating threads, through perf_event_open on Linux
+//
+// Each thread opens its own counters the first time it is measured, and keeps them
+// for its lifetime, so the worker threads of the backends are measured, while they work,
+// without counting the time they spin or sleep between rows. Where the counters can't
+// be opened, because of the platform, the kernel settings or a virtual machine, the
+// measurements are simply empty, and reported as not available.
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct PerfCounts
+{
+	uint64_t cycles = 0;
+	uint64_t instructions = 0;
+	uint64_t branchMisses = 0;
+	uint64_t cacheMisses = 0;
+	uint64_t taskClock = 0;		// Nanoseconds of CPU time, a software counter
+
+	PerfCounts operator-(const PerfCounts& other) const
+	{
+		PerfCounts d;
+		d.cycles = cycles - other.cycles;
+		d.instructions = instructions - other.instructions;
+		d.branchMisses = branchMisses - other.branchMisses;
+		d.cacheMisses = cacheMisses - other.cacheMisses;
+		d.taskClock = taskClock - other.taskClock;
+		return d;
+	}
+
+	double IPC() const { return cycles ? double(instructions) / cycles : 0.0; }
+};
+
+// The counters of the calling thread
+class PerfThreadCounters
+{
+public:
+	static PerfThreadCounters& Current()
+	{
+		thread_local PerfThreadCounters counters;
+		return counters;
+	}
+
+	bool HasHardware() const { return hardwareFd >= 0; }
+	bool HasClock() const { return clockFd >= 0; }
+
+	void Read(PerfCounts& counts) const
+	{
+#if defined(__linux__)
+		if (hardwareFd >= 0)
+		{
+			// Group read: number of counters, time enabled and running, then the values in order of opening
+			uint64_t data[3 + hardwareEvents] = {};
+			if (::read(hardwareFd, data, sizeof(data)) == ssize_t(sizeof(data)) && data[2] > 0)
+			{
+				// Scaled up when the counters were multiplexed with others
+				const double scale = double(data[1]) / double(data[2]);
+				counts.cycles = uint64_t(data[3] * scale);
+				counts.instructions = uint64_t(data[4] * scale);
+				counts.branchMisses = uint64_t(data[5] * scale);
+				counts.cacheMisses = uint64_t(data[6] * scale);
+			}
+		}
+		if (clockFd >= 0)
+		{
+			uint64_t value = 0;
+			if (::read(clockFd, &value, sizeof(value)) == ssize_t(sizeof(value)))
+				counts.taskClock = value;
+		}
+#else
+		(void)counts;
+#endif
+	}
+
+	~PerfThreadCounters()
+	{
+#if defined(__linux__)
+		for (int fd : memberFds)
+		{
+			if (fd >= 0)
+				::close(fd);
+		}
+		if (hardwareFd >= 0)
+			::close(hardwareFd);
+		if (clockFd >= 0)
+			::close(clockFd);
+#endif
+	}
+
+private:
+	static const int hardwareEvents = 4;
+
+	PerfThreadCounters()
+	{
+#if defined(__linux__)
+		static const uint64_t events[hardwareEvents] =
+		{
+			PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+		};
+
+		// All hardware counters in one group, so they are read in one call and scheduled together
+		for (int i = 0; i < hardwareEvents; i++)
+		{
+			int fd = Open(PERF_TYPE_HARDWARE, events[i], i == 0 ? -1 : hardwareFd);
+			if (fd < 0)
+			{
+				Close();
+				break;
+			}
+			if (i == 0)
+				hardwareFd = fd;
+			else
+				memberFds[i - 1] = fd;
+		}
+		if (hardwareFd >= 0)
+			ioctl(hardwareFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+		clockFd = Open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, -1);
+		if (clockFd >= 0)
+			ioctl(clockFd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+
+#if defined(__linux__)
+	static int Open(uint32_t type, uint64_t config, int groupFd)
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = groupFd < 0 ? 1 : 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		if (groupFd < 0 && type == PERF_TYPE_HARDWARE)
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		// This thread, on any CPU
+		return int(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+	}
+
+	void Close()
+	{
+		for (int& fd : memberFds)
+		{
+			if (fd >= 0)
+				::close(fd);
+			fd = -1;
+		}
+		if (hardwareFd >= 0)
+			::close(hardwareFd);
+		hardwareFd = -1;
+	}
+#endif
+
+	int hardwareFd = -1;	// Group leader, the cycles
+	int memberFds[hardwareEvents - 1] = { -1, -1, -1 };
+	int clockFd = -1;
+};
+
+// The counts of all the threads measured for one render, added to from any thread
+class PerfTotals
+{
+public:
+	void Reset()
+	{
+		cycles = instructions = branchMisses = cacheMisses = taskClock = 0;
+		hardware = clock = false;
+	}
+
+	void Add(const PerfCounts& delta, bool hasHardware, bool hasClock)
+	{
+		cycles += delta.cycles;
+		instructions += delta.instructions;
+		branchMisses += delta.branchMisses;
+		cacheMisses += delta.cacheMisses;
+		taskClock += delta.taskClock;
+		if (hasHardware)
+			hardware = true;
+		if (hasClock)
+			clock = true;
+	}
+
+	PerfCounts Get() const
+	{
+		PerfCounts counts;
+		counts.cycles = cycles;
+		counts.instructions = instructions;
+		counts.branchMisses = branchMisses;
+		counts.cacheMisses = cacheMisses;
+		counts.taskClock = taskClock;
+		return counts;
+	}
+
+	bool HasHardware() const { return hardware; }
+	bool HasClock() const { return clock; }
+
+	// One line summary, per pixel of a view with the given number of pixels
+	std::string Describe(double pixels) const
+	{
+		if (!clock && !hardware)
+			return "not available";
+
+		const PerfCounts c = Get();
+		auto perPixel = [pixels] (uint64_t value) { return std::to_string(pixels > 0 ? value / pixels : 0.0); };
+
+		std::string text;
+		if (hardware)
+		{
+			text = "IPC " + std::to_string(c.IPC()) + ", per pixel " + perPixel(c.cycles) + " cycles, "
+				+ perPixel(c.instructions) + " instructions, " + perPixel(c.branchMisses) + " branch misses, "
+				+ perPixel(c.cacheMisses) + " cache misses";
+		}
+		else
+		{
+			text = "no hardware counters";
+		}
+		if (clock)
+			text += ", " + perPixel(c.taskClock) + " CPU ns per pixel";
+
+		return text;
+	}
+
+private:
+	std::atomic<uint64_t> cycles{ 0 };
+	std::atomic<uint64_t> instructions{ 0 };
+	std::atomic<uint64_t> branchMisses{ 0 };
+	std::atomic<uint64_t> cacheMisses{ 0 };
+	std::atomic<uint64_t> taskClock{ 0 };
+	std::atomic<bool> hardware{ false };
+	std::atomic<bool> clock{ false };
+};
+
+// Counts of the calling thread from construction to destruction, added to the totals
+// Does nothing without totals
+class PerfScope
+{
+public:
+	PerfScope(PerfTotals* totals_) : totals(totals_)
+	{
+		if (totals)
+			PerfThreadCounters::Current().Read(start);
+	}
+
+	~PerfScope()
+	{
+		if (!totals)
+			return;
+
+		const PerfThreadCounters& counters = PerfThreadCounters::Current();
+		PerfCounts end;
+		counters.Read(end);
+		totals->Add(end - start, counters.HasHardware(), counters.HasClock());
+	}
+
+	PerfScope(const PerfScope&) = delete;
+	PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+	PerfTotals* totals;
+	PerfCounts start;
+};
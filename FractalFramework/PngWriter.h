@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "olcPixelGameEngine.h"
+
+// Minimal PNG writer, for saving images without a PNG library
+// The image data is stored uncompressed in the zlib stream, which every PNG reader accepts
+class PngWriter
+{
+public:
+	static bool Write(const std::string& path, const olc::Pixel* pixels, int width, int height)
+	{
+		// Scanlines of RGBA, each preceded by filter type 0 (none)
+		std::vector<uint8_t> raw;
+		raw.reserve(size_t(height) * (size_t(width) * 4 + 1));
+		for (int y = 0; y < height; y++)
+		{
+			raw.push_back(0);
+			const olc::Pixel* row = pixels + size_t(y) * width;
+			for (int x = 0; x < width; x++)
+			{
+				raw.push_back(row[x].r);
+				raw.push_back(row[x].g);
+				raw.push_back(row[x].b);
+				raw.push_back(row[x].a);
+			}
+		}
+
+		// zlib stream of stored deflate blocks, at most 65535 bytes each
+		std::vector<uint8_t> zlib = { 0x78, 0x01 };
+		size_t offset = 0;
+		do
+		{
+			const size_t length = std::min(raw.size() - offset, size_t(65535));
+			const bool last = offset + length == raw.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(uint8_t(length));
+			zlib.push_back(uint8_t(length >> 8));
+			zlib.push_back(uint8_t(~length));
+			zlib.push_back(uint8_t(~length >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+			offset += length;
+		} while (offset < raw.size());
+		PutBigEndian(zlib, Adler32(raw));
+
+		std::vector<uint8_t> header;
+		PutBigEndian(header, uint32_t(width));
+		PutBigEndian(header, uint32_t(height));
+		header.insert(header.end(), { 8, 6, 0, 0, 0 });	// 8 bits, RGBA, deflate, adaptive filters, no interlace
+
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		bool ok = std::fwrite(signature, 1, sizeof(signature), file) == sizeof(signature);
+		ok = ok && WriteChunk(file, "IHDR", header);
+		ok = ok && WriteChunk(file, "IDAT", zlib);
+		ok = ok && WriteChunk(file, "IEND", {});
+
+		return std::fclose(file) == 0 && ok;
+	}
+
+private:
+	static void PutBigEndian(std::vector<uint8_t>& data, uint32_t value)
+	{
+		data.insert(data.end(), { uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value) });
+	}
+
+	static uint32_t Adler32(const std::vector<uint8_t>& data)
+	{
+		uint32_t a = 1, b = 0;
+		for (uint8_t d : data)
+		{
+			a = (a + d) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	static uint32_t Crc32(const uint8_t* data, size_t length, uint32_t crc = 0xFFFFFFFFu)
+	{
+		static std::vector<uint32_t> table;
+		if (table.empty())
+		{
+			table.resize(256);
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				table[n] = c;
+			}
+		}
+
+		for (size_t i = 0; i < length; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return crc;
+	}
+
+	static bool WriteChunk(FILE* file, const char* type, const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> chunk;
+		PutBigEndian(chunk, uint32_t(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		PutBigEndian(chunk, Crc32(chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFFu);
+
+		return std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+	}
+};
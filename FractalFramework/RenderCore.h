@@ -0,0 +1,762 @@
+#pragma once
+
+// Render core of the Fractal Framework, without any dependency on PixelGameEngine
+//
+// A render takes a view (what to calculate), settings (how to calculate it), a
+// prototype IComputePoint (the formula and interior method) and a target (where the
+// values go). The same core is used by the interactive framework, the batch renderer
+// and the benchmarks, so they all measure and show the same calculation.
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <cmath>
+#include <chrono>
+#include <typeinfo>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <ppl.h>
+#if defined(USE_TBB_WITH_MSC)
+	// Demands installation of OneTBB for Windows/MSVC
+	#include <tbb/tbb.h>
+#endif
+#endif
+
+#if defined(__GNUG__)
+#include "tbb/tbb.h"
+#endif
+
+#include "IterativeCompute.h"
+#include "RenderPlanner.h"
+#include "ResultBuffer.h"
+#include "PerfCounters.h"
+#include "CostMap.h"
+#include "Trace.h"
+#include "EscapeKernels.h"
+
+// What to render: a part of the plane, its size in pixels and the constants of the formula
+struct RenderView
+{
+	int width = 0, height = 0;
+	double tlx = 0.0, tly = 0.0;	// World coordinates of the top left corner
+	double brx = 0.0, bry = 0.0;	// and of the bottom right corner
+	bool julia = false;
+	double seedr = 0.0, seedi = 0.0;	// The constant of julia sets
+	double z0r = 0.0, z0i = 0.0;		// The start value otherwise
+};
+
+// View of worldWidth wide around a center, with square pixels
+// The imaginary axis points up, as in the framework, so row 0 is the highest
+inline RenderView CenteredView(int width, int height, double centerx, double centery, double worldWidth)
+{
+	RenderView view;
+	const double worldHeight = worldWidth * height / width;
+
+	view.width = width;
+	view.height = height;
+	view.tlx = centerx - worldWidth / 2;
+	view.tly = centery + worldHeight / 2;
+	view.brx = view.tlx + worldWidth;
+	view.bry = view.tly - worldHeight;
+
+	return view;
+}
+
+// Iterations as given by the escape counts, inside points counted as the full limit,
+// also when the interior method stopped them earlier
+inline uint64_t NominalIterations(const int* values, size_t n, int maxIterations)
+{
+	uint64_t iterations = 0;
+	for (size_t i = 0; i < n; i++)
+		iterations += uint64_t(std::min(values[i], maxIterations));
+	return iterations;
+}
+
+// Value at fraction of the values, nearest rank, 0 without values
+inline double NearestRankPercentile(std::vector<double> values, double fraction)
+{
+	if (values.empty())
+		return 0.0;
+
+	std::sort(values.begin(), values.end());
+	size_t rank = size_t(std::ceil(fraction * values.size()));
+	return values[std::min(values.size(), std::max(size_t(1), rank)) - 1];
+}
+
+// How the rows are handed out to the threads, by the backends with thread control
+enum class RenderSchedule
+{
+	Dynamic,	// Chunks of grain rows, each to the next free thread
+	Static,		// Chunks of grain rows, divided over the threads beforehand
+	Guided		// Chunks shrinking down to grain rows, to the next free thread
+};
+
+inline const char* ScheduleName(RenderSchedule schedule)
+{
+	static const char* names[] = { "dynamic", "static", "guided" };
+	return names[int(schedule)];
+}
+
+// The schedule by name, false for unknown names
+inline bool FindSchedule(const std::string& name, RenderSchedule& schedule)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (name == ScheduleName(RenderSchedule(i)))
+		{
+			schedule = RenderSchedule(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+// How to render it
+struct RenderSettings
+{
+	size_t backend = 0;				// Index into RenderEngine::Backends()
+	int threads = 0;				// Worker threads, 0 for the default of the backend
+	int grain = 1;					// Rows per chunk handed out to a thread
+	RenderSchedule schedule = RenderSchedule::Dynamic;
+	bool useSymmetry = true;		// Mirror the symmetric part of the view
+	bool diskFilling = false;		// Skip pixels proven to be outside by the distance estimate
+	double diskFillSafety = 0.5;	// Fraction of the Koebe 1/4 bound actually trusted
+	int diskFillStep = 8;			// Pixels between the distance estimated samples
+	bool useKernels = true;			// Vector kernels of the selected instruction set, where they apply
+	PerfTotals* counters = nullptr;	// When set, the counters of the workers are added to it, row by row
+	CostMap* costs = nullptr;		// When set, the time and iterations of every calculated span, by tile of the view
+	WorkerLoad* load = nullptr;		// When set, the busy time of every thread
+};
+
+// Where the results go, each with width * height of the view, row by row
+struct RenderTarget
+{
+	int* values = nullptr;				// Packed values, as ComputePointCount() gives them
+	ResultBuffer* results = nullptr;	// All the channels, when set, and values packed from them
+	InteriorMode packMode = InteriorMode::Plain;
+};
+
+struct RenderCallbacks
+{
+	// Called by the calculating threads for each finished span of pixels, as offset into the values
+	std::function<void(size_t offset, int length)> progress;
+	// Polled while calculating, the render stops soon after it returns true
+	std::function<bool()> cancelled;
+};
+
+struct RenderResult
+{
+	RenderPlan plan;
+	bool completed = false;			// Not cancelled
+	double mirroredFraction = 0.0;	// Of all pixels
+	double diskFilledFraction = 0.0;	// Of the calculated pixels
+};
+
+// The start value and bailout the framework uses with a formula
+struct FormulaDefaults
+{
+	double z0r = 0.0, z0i = 0.0;
+	double bailoutSquare = 4.0;
+};
+
+// Formulas and interior methods by their short names, as selected by M, B and G,
+// and by L, C and I in the framework. nullptr for unknown names
+inline IComputeState* CreateComputeState(const std::string& name, FormulaDefaults& defaults)
+{
+	defaults = FormulaDefaults();
+
+	if (name == "mandelbrot")
+		return new MandelComputeState;
+	if (name == "burningship")
+		return new BurningShipComputeState;
+	if (name == "logistic")
+	{
+		defaults.z0r = 0.5;
+		defaults.bailoutSquare = 16.0;
+		return new LogisticComputeState;
+	}
+	return nullptr;
+}
+
+inline IComputePoint* CreateComputePoint(const std::string& interior)
+{
+	if (interior == "plain")
+		return new ComputePoint;
+	if (interior == "loop")
+		return new ComputePointWithLoop;
+	if (interior == "convergence")
+		return new ComputePointWithConvergence;
+	if (interior == "index")
+		return new ComputePointWithIndex;
+	return nullptr;
+}
+
+// The compiler and the kind of build, for the HUD and for reports
+inline std::string buildCompilerString()
+{
+	std::string compiler = "Unknown";
+#if defined(_MSC_VER)
+	#if defined(__clang_version__)
+		compiler = "Visual Studio clang ("  __clang_version__ ")";
+	#else
+		compiler = "MSVC";
+	#endif
+
+	#if !defined(NDEBUG)
+		compiler += " (debug build)";
+	#endif
+#elif defined(__GNUG__)
+	#if defined(__MINGW64__)
+		compiler = "MinGW64";
+	#elif defined(__clang_version__)
+		compiler = "clang ("  __clang_version__ ")";
+	#else
+		compiler = "g++";
+	#endif
+
+	#if !defined(__OPTIMIZE__)
+		compiler += " (debug build)";
+	#endif
+#elif defined(__clang_version__)
+	compiler = "clang ("  __clang_version__ ")";
+#endif
+
+	return compiler;
+}
+
+using RowFunction = std::function<void(IComputePoint& point, int y)>;
+
+// A way of running the rows of a rectangle, in parallel or not
+// Every row gets a copy of the prototype, or at least every thread
+struct RenderBackend
+{
+	const char* name;			// Short name, for command lines and reports
+	const char* description;
+	bool threadControl;			// Uses RenderSettings::threads, grain and schedule, the others always use their default
+	void (*forEachRow)(IComputePoint& prototype, int y0, int y1, const RenderSettings& settings, const RowFunction& row);
+};
+
+class RenderEngine
+{
+public:
+	RenderEngine(const RenderView& view_, const RenderSettings& settings_, IComputePoint& prototype_, const RenderTarget& target_, const RenderCallbacks& callbacks_ = RenderCallbacks())
+		: view(view_), settings(settings_), prototype(prototype_), target(target_), callbacks(callbacks_)
+	{
+		// The kernels only calculate the escape counts of the plain Mandelbrot formula
+		if (settings.useKernels && !target.results && typeid(prototype) == typeid(ComputePoint)
+			&& prototype.z && typeid(*prototype.z) == typeid(MandelComputeState))
+		{
+			escapeKernel = SelectedEscapeKernel();
+		}
+	}
+
+	static const std::vector<RenderBackend>& Backends()
+	{
+		static const std::vector<RenderBackend> backends =
+		{
+			{ "openmp", "OpenMP parallel for", true, &ForEachRowOpenMP },
+			{ "single", "Single Thread Method", false, &ForEachRowSingleThread },
+			{ "cpp17", "C++17 for_each_n parallel implementation", false, &ForEachRowCppForEach },
+#if defined(_MSC_VER)
+			{ "ppl", "MS parallel_for", false, &ForEachRowParallelization },
+#endif
+#if defined(__GNUG__) || defined(USE_TBB_WITH_MSC)
+			{ "tbb", "oneTBB parallel_for", true, &ForEachRowTbb },
+#endif
+		};
+		return backends;
+	}
+
+	// Index of the backend, or -1 when it is not in this build
+	static int FindBackend(const std::string& name)
+	{
+		const auto& backends = Backends();
+		for (size_t i = 0; i < backends.size(); i++)
+		{
+			if (name == backends[i].name)
+				return int(i);
+		}
+		return -1;
+	}
+
+	// Calculate the whole view
+	RenderResult Render()
+	{
+		TRACE_SCOPE("render");
+		RenderResult result;
+
+		plan = PlanRender(view.width, view.height, view.tlx, view.tly, view.brx, view.bry,
+						  prototype.z->GetSymmetry(view.julia, view.z0r, view.z0i), settings.useSymmetry);
+		diskFilledPixels = 0;
+
+		for (const auto& r : plan.compute)
+		{
+			if (settings.diskFilling)
+				DiskFill(r);
+			else
+				ForEachRow(r.y0, r.y1, [this, &r] (IComputePoint& point, int y) { ComputeRow(point, y, r.x0, r.x1); });
+		}
+
+		if (!Cancelled())
+			MirrorPlan();
+
+		const double pixels = double(view.width) * double(view.height);
+		result.plan = plan;
+		result.completed = !Cancelled();
+		result.mirroredFraction = double(plan.mirror.x1 - plan.mirror.x0) * double(plan.mirror.y1 - plan.mirror.y0) / pixels;
+		// Mirrored pixels are filled as well, if their origin was
+		result.diskFilledFraction = double(diskFilledPixels) / ((1.0 - result.mirroredFraction) * pixels);
+
+		return result;
+	}
+
+	// More iterations for a completed render with the given plan: only the pixels at the old limit
+	// are calculated again, escaped pixels keep their counts, as a higher limit doesn't change those
+	// As in Render(), only the calculated parts of the plan are resumed, the rest is mirrored from them
+	// Returns the number of pixels calculated again
+	size_t Resume(const RenderPlan& plan_, int oldIterations)
+	{
+		TRACE_SCOPE("resume");
+		plan = plan_;
+		std::atomic<size_t> resumed{ 0 };
+
+		for (const auto& r : plan.compute)
+		{
+			ForEachRow(r.y0, r.y1, [this, &r, oldIterations, &resumed] (IComputePoint& point, int y)
+				{
+					const int* row = target.values + size_t(y) * view.width;
+
+					// Runs of unresolved pixels, calculated as parts of the row
+					int x = r.x0;
+					while (x < r.x1 && !Cancelled())
+					{
+						if (row[x] < oldIterations)
+						{
+							x++;
+							continue;
+						}
+
+						int end = x + 1;
+						while (end < r.x1 && row[end] >= oldIterations)
+							end++;
+
+						ComputeRow(point, y, x, end);
+						resumed += end - x;
+						x = end;
+					}
+				});
+		}
+
+		if (!Cancelled())
+			MirrorPlan();
+
+		return resumed;
+	}
+
+private:
+	static const int cancelStep = 16;
+
+	// Copy the mirrored part of the plan from the calculated parts, counts and result channels
+	void MirrorPlan()
+	{
+		TRACE_SCOPE("mirror");
+		plan.Mirror(target.values, view.width);
+		if (target.results)
+			target.results->ForEachChannel([this] (auto* channel) { plan.Mirror(channel, view.width); });
+
+		for (int y = plan.mirror.y0; y < plan.mirror.y1; y++)
+			Progress(size_t(y) * view.width + plan.mirror.x0, plan.mirror.x1 - plan.mirror.x0);
+	}
+
+	bool Cancelled()
+	{
+		if (!stopped && callbacks.cancelled && callbacks.cancelled())
+			stopped = true;
+		return stopped;
+	}
+
+	// Calculate pixels x0 to x1 of row y into the target
+	void ComputeRow(IComputePoint& point, int y, int x0, int x1)
+	{
+		const size_t y_offset = size_t(y) * view.width;
+
+		if (!settings.costs)
+		{
+			if (!ComputeSpan(point, y, x0, x1))
+				return;
+		}
+		else
+		{
+			// Timed by the part of the row in each tile
+			for (int begin = x0; begin < x1; )
+			{
+				const int end = std::min(x1, (begin / CostMap::tileSize + 1) * CostMap::tileSize);
+
+				auto tp1 = std::chrono::steady_clock::now();
+				if (!ComputeSpan(point, y, begin, end))
+					return;
+				auto tp2 = std::chrono::steady_clock::now();
+
+				const uint64_t iterations = NominalIterations(target.values + y_offset + begin, size_t(end - begin), point.maxIterations);
+				settings.costs->Add(begin, y, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(tp2 - tp1).count()), iterations);
+				begin = end;
+			}
+		}
+
+		Progress(y_offset + x0, x1 - x0);
+	}
+
+	// The calculation of ComputeRow(), false when cancelled
+	bool ComputeSpan(IComputePoint& point, int y, int x0, int x1)
+	{
+		const size_t y_offset = size_t(y) * view.width;
+		const double y_pos = plan.tly + y * plan.y_scale;
+		const int maxIterations = point.maxIterations;
+
+		PointResult r;
+
+		// Cancellation is polled for every few pixels, rows can be long and slow
+		for (int begin = x0; begin < x1; begin += cancelStep)
+		{
+			if (Cancelled())
+				return false;
+
+			const int end = std::min(x1, begin + cancelStep);
+			if (escapeKernel)
+			{
+				double xs[cancelStep];
+				for (int x = begin; x < end; x++)
+					xs[x - begin] = plan.tlx + x * plan.x_scale;
+
+				EscapeKernelParams params;
+				params.julia = view.julia;
+				params.seedr = view.seedr;
+				params.seedi = view.seedi;
+				params.z0r = view.z0r;
+				params.z0i = view.z0i;
+				params.bailOutSquare = point.bailOutSquare;
+				params.maxIterations = maxIterations;
+				escapeKernel(xs, end - begin, y_pos, params, target.values + y_offset + begin);
+				continue;
+			}
+
+			for (int x = begin; x < end; x++)
+			{
+				const double x_pos = plan.tlx + x * plan.x_scale;
+
+				if (target.results)
+				{
+					if (view.julia)
+						point.ComputePointResult(view.seedr, view.seedi, x_pos, y_pos, r);
+					else
+						point.ComputePointResult(x_pos, y_pos, view.z0r, view.z0i, r);
+
+					target.results->Store(y_offset + x, r);
+					target.values[y_offset + x] = target.results->Pack(y_offset + x, target.packMode, maxIterations);
+				}
+				else if (view.julia)
+					target.values[y_offset + x] = point.ComputePointCount(view.seedr, view.seedi, x_pos, y_pos);
+				else
+					target.values[y_offset + x] = point.ComputePointCount(x_pos, y_pos, view.z0r, view.z0i);
+			}
+		}
+
+		return true;
+	}
+
+	void Progress(size_t offset, int length)
+	{
+		if (callbacks.progress && length > 0 && !Cancelled())
+			callbacks.progress(offset, length);
+	}
+
+	void ForEachRow(int y0, int y1, const RowFunction& row)
+	{
+		ForEachRow(prototype, y0, y1, row);
+	}
+
+	// With copies of another calculation for the rows
+	void ForEachRow(IComputePoint& rowPrototype, int y0, int y1, const RowFunction& row)
+	{
+		const RenderBackend& backend = Backends()[settings.backend];
+		if (!settings.counters && !settings.load && !Trace::enabled)
+		{
+			backend.forEachRow(rowPrototype, y0, y1, settings, row);
+			return;
+		}
+
+		// Measured while working on a row, not while waiting for the next
+		PerfTotals* counters = settings.counters;
+		WorkerLoad* load = settings.load;
+		backend.forEachRow(rowPrototype, y0, y1, settings, [counters, load, &row] (IComputePoint& point, int y)
+			{
+				TRACE_SCOPE("row");
+				PerfScope scope(counters);
+				WorkerScope busy(load);
+				row(point, y);
+			});
+	}
+
+	static void ForEachRowOpenMP(IComputePoint& prototype, int y0, int y1, const RenderSettings& settings, const RowFunction& row)
+	{
+		// We need a copy for each parallel task, possibly down to each y coordinate
+		auto body = [&prototype, &row] (int y)
+			{
+				std::unique_ptr<IComputePoint> point(prototype.Clone());
+				row(*point, y);
+			};
+
+		int y;
+#if defined(_OPENMP)
+		const int grain = std::max(1, settings.grain);
+		const int n = settings.threads > 0 ? settings.threads : omp_get_max_threads();
+#endif
+		switch (settings.schedule)
+		{
+		case RenderSchedule::Static:
+#pragma omp parallel for schedule(static, grain) num_threads(n)
+			for (y = y0; y < y1; y++)
+				body(y);
+			break;
+		case RenderSchedule::Guided:
+#pragma omp parallel for schedule(guided, grain) num_threads(n)
+			for (y = y0; y < y1; y++)
+				body(y);
+			break;
+		default:
+#pragma omp parallel for schedule(dynamic, grain) num_threads(n)
+			for (y = y0; y < y1; y++)
+				body(y);
+			break;
+		}
+	}
+
+	static void ForEachRowSingleThread(IComputePoint& prototype, int y0, int y1, const RenderSettings& /* settings */, const RowFunction& row)
+	{
+		// We only need one for the whole picture
+		std::unique_ptr<IComputePoint> point(prototype.Clone());
+		for (int y = y0; y < y1; y++)
+			row(*point, y);
+	}
+
+	// Using built C++17 parallelization
+	static void ForEachRowCppForEach(IComputePoint& prototype, int y0, int y1, const RenderSettings& /* settings */, const RowFunction& row)
+	{
+		std::vector<int> indexes(y1 - y0);
+		std::iota(indexes.begin(), indexes.end(), y0);
+
+		std::for_each_n(std::execution::par, indexes.begin(), y1 - y0, [&] (int y)
+			{
+				std::unique_ptr<IComputePoint> point(prototype.Clone());
+				row(*point, y);
+			});
+	}
+
+#if defined(_MSC_VER)
+	// _MSC_VER is also defined for clang under VS (clang-cl)
+	// Using concurrency library parallelization
+	static void ForEachRowParallelization(IComputePoint& prototype, int y0, int y1, const RenderSettings& /* settings */, const RowFunction& row)
+	{
+		concurrency::parallel_for(y0, y1, [&] (int y)
+			{
+				std::unique_ptr<IComputePoint> point(prototype.Clone());
+				row(*point, y);
+			});
+	}
+#endif
+
+#if defined(__GNUG__) || defined(USE_TBB_WITH_MSC)
+	// Using oneTBB library parallelization
+	// The schedules as partitioners: simple for dynamic, static, and auto for guided
+	static void ForEachRowTbb(IComputePoint& prototype, int y0, int y1, const RenderSettings& settings, const RowFunction& row)
+	{
+		const tbb::blocked_range<int> range(y0, y1, size_t(std::max(1, settings.grain)));
+		auto body = [&prototype, &row] (const tbb::blocked_range<int>& rows)
+			{
+				for (int y = rows.begin(); y < rows.end(); y++)
+				{
+					std::unique_ptr<IComputePoint> point(prototype.Clone());
+					row(*point, y);
+				}
+			};
+
+		tbb::task_arena arena(settings.threads > 0 ? settings.threads : int(tbb::task_arena::automatic));
+		arena.execute([&]
+			{
+				switch (settings.schedule)
+				{
+				case RenderSchedule::Static:
+					tbb::parallel_for(range, body, tbb::static_partitioner());
+					break;
+				case RenderSchedule::Guided:
+					tbb::parallel_for(range, body, tbb::auto_partitioner());
+					break;
+				default:
+					tbb::parallel_for(range, body, tbb::simple_partitioner());
+					break;
+				}
+			});
+	}
+#endif
+
+	// Calculate a grid of samples with distance estimates first. A cell of the grid,
+	// where all corners are outside, and where the disk around one corner, known to be free
+	// of the set, covers the whole cell, is filled by interpolation instead of calculation
+	// Both passes run their rows of samples and of cells with the selected backend
+	void DiskFill(const RenderRect& rect)
+	{
+		const int row_size = view.width;
+		const int maxIterations = prototype.maxIterations;
+		const int step = settings.diskFillStep;
+
+		// Sample positions, every step pixel, and always the last pixel
+		auto samplePositions = [step] (int begin, int end)
+			{
+				std::vector<int> positions;
+				for (int p = begin; p < end - 1; p += step)
+					positions.push_back(p);
+				positions.push_back(end - 1);
+				return positions;
+			};
+		const std::vector<int> xs = samplePositions(rect.x0, rect.x1);
+		const std::vector<int> ys = samplePositions(rect.y0, rect.y1);
+		const int nx = int(xs.size()), ny = int(ys.size());
+
+		// The sample calculation is the current one, with a distance estimate added
+		std::unique_ptr<ComputePointFull> deTemplate(new ComputePointFull);
+		deTemplate->z.reset(prototype.z->Clone());
+		deTemplate->maxIterations = maxIterations;
+		deTemplate->bailOutSquare = prototype.bailOutSquare;
+		deTemplate->channels = (target.results ? target.results->getChannels() : unsigned(ChannelCount)) | ChannelDistance;
+		deTemplate->julia = view.julia;
+
+		std::vector<PointResult> samples(size_t(nx) * ny);
+
+		ForEachRow(*deTemplate, 0, ny, [&] (IComputePoint& dePoint, int j)
+			{
+				TRACE_SCOPE("disk fill samples");
+				const double y_pos = plan.tly + ys[j] * plan.y_scale;
+
+				for (int i = 0; i < nx && !Cancelled(); i++)
+				{
+					const double x_pos = plan.tlx + xs[i] * plan.x_scale;
+					PointResult& r = samples[size_t(j) * nx + i];
+
+					if (view.julia)
+						dePoint.ComputePointResult(view.seedr, view.seedi, x_pos, y_pos, r);
+					else
+						dePoint.ComputePointResult(x_pos, y_pos, view.z0r, view.z0i, r);
+
+					if (r.count < maxIterations && !r.looped)
+					{
+						// Escaped samples are final, inside ones are calculated with their cell
+						// Looped ones are inside for the modes checking loops
+						const int index = ys[j] * row_size + xs[i];
+						if (target.results)
+						{
+							target.results->Store(index, r);
+							target.values[index] = target.results->Pack(index, target.packMode, maxIterations);
+						}
+						else
+						{
+							target.values[index] = r.count;
+						}
+					}
+				}
+			});
+
+		const double pixelSize = std::abs(plan.x_scale);
+
+		// Cells own the pixels from their top left corner, up to the next cell,
+		// the last cells also own the last row and column
+		ForEachRow(0, std::max(1, ny - 1), [&] (IComputePoint& point, int j)
+			{
+				TRACE_SCOPE("disk fill cells");
+
+				const int j1 = std::min(j + 1, ny - 1);
+				const int cy0 = ys[j], cy1 = (j1 == ny - 1) ? ys[j1] + 1 : ys[j1];
+				size_t filled = 0;
+
+				for (int i = 0; i < std::max(1, nx - 1) && !Cancelled(); i++)
+				{
+					const int i1 = std::min(i + 1, nx - 1);
+					const int cx0 = xs[i], cx1 = (i1 == nx - 1) ? xs[i1] + 1 : xs[i1];
+
+					const PointResult* corners[4] =
+					{
+						&samples[size_t(j) * nx + i], &samples[size_t(j) * nx + i1],
+						&samples[size_t(j1) * nx + i], &samples[size_t(j1) * nx + i1]
+					};
+
+					bool fillable = true;
+					double radius = 0.0;
+					for (const PointResult* c : corners)
+					{
+						fillable &= c->count < maxIterations && !c->looped;
+						radius = std::max(radius, settings.diskFillSafety * 0.25 * c->distance / pixelSize);
+					}
+					// The disk around one corner must cover the cell, up to the opposite corner
+					const double diagonal = std::hypot(double(xs[i1] - xs[i]), double(ys[j1] - ys[j]));
+					fillable &= radius > diagonal;
+
+					for (int y = cy0; y < cy1; y++)
+					{
+						if (!fillable)
+						{
+							ComputeRow(point, y, cx0, cx1);
+							continue;
+						}
+
+						const float v = ys[j1] > ys[j] ? float(y - ys[j]) / float(ys[j1] - ys[j]) : 0.0f;
+						for (int x = cx0; x < cx1; x++)
+						{
+							if ((x == xs[i] || x == xs[i1]) && (y == ys[j] || y == ys[j1]))
+								continue;	// Samples are calculated already
+
+							const float u = xs[i1] > xs[i] ? float(x - xs[i]) / float(xs[i1] - xs[i]) : 0.0f;
+							auto lerp = [u, v, &corners] (auto PointResult::* field)
+								{
+									float top = float(corners[0]->*field) * (1 - u) + float(corners[1]->*field) * u;
+									float bottom = float(corners[2]->*field) * (1 - u) + float(corners[3]->*field) * u;
+									return top * (1 - v) + bottom * v;
+								};
+
+							PointResult r;
+							r.count = std::min(maxIterations - 1, int(lerp(&PointResult::count) + 0.5f));
+							r.smooth = lerp(&PointResult::smooth);
+							r.distance = lerp(&PointResult::distance);
+
+							const int index = y * row_size + x;
+							if (target.results)
+								target.results->Store(index, r);
+							target.values[index] = r.count;
+							filled++;
+						}
+						Progress(size_t(y) * row_size + cx0, cx1 - cx0);
+					}
+				}
+
+				diskFilledPixels += filled;
+			});
+	}
+
+	RenderView view;
+	RenderSettings settings;
+	IComputePoint& prototype;
+	RenderTarget target;
+	RenderCallbacks callbacks;
+
+	RenderPlan plan;
+	std::atomic<bool> stopped{ false };
+	std::atomic<size_t> diskFilledPixels{ 0 };
+	EscapeKernel escapeKernel = nullptr;
+};
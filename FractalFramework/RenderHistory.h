@@ -0,0 +1,50 @@
+#pragma once
+
+// Rolling statistics of the last completed renders, for the dashboard
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "RenderCore.h"
+
+class RenderHistory
+{
+public:
+	static const size_t capacity = 32;
+
+	struct Render
+	{
+		double seconds = 0.0;
+		double pixels = 0.0;
+		double iterations = 0.0;	// Nominal, from the escape counts
+	};
+
+	void Add(double seconds, double pixels, double iterations)
+	{
+		renders.push_back({ seconds, pixels, iterations });
+		if (renders.size() > capacity)
+			renders.pop_front();
+	}
+
+	size_t Count() const { return renders.size(); }
+	const Render& Last() const { return renders.back(); }
+
+	// Nearest rank percentile of the render times, 0 without renders
+	double Percentile(double p) const
+	{
+		std::vector<double> times;
+		for (const auto& r : renders)
+			times.push_back(r.seconds);
+		return NearestRankPercentile(times, p);
+	}
+
+	double Median() const { return Percentile(0.5); }
+	double P95() const { return Percentile(0.95); }
+
+	double MPixelsPerSecond() const { return !renders.empty() && Last().seconds > 0 ? Last().pixels / Last().seconds / 1e6 : 0.0; }
+	double GIterationsPerSecond() const { return !renders.empty() && Last().seconds > 0 ? Last().iterations / Last().seconds / 1e9 : 0.0; }
+
+private:
+	std::deque<Render> renders;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "IterativeCompute.h"
+
+// Rectangle of pixels, x1 and y1 are exclusive
+struct RenderRect
+{
+	int x0, y0, x1, y1;
+
+	bool IsEmpty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+// Splits a view into the parts that must be calculated,
+// and the part which can be mirrored from the calculated parts
+struct RenderPlan
+{
+	// World coordinates of pixel (0, 0), and world units per pixel
+	double tlx, tly;
+	double x_scale, y_scale;
+
+	std::vector<RenderRect> compute;
+
+	// Pixel (x, y) in mirror is copied from (kx - x, ky - y), or (x, ky - y) for the real axis
+	Symmetry symmetry = Symmetry::Asymmetric;
+	RenderRect mirror = { 0, 0, 0, 0 };
+	int kx = 0, ky = 0;
+
+	template <typename T>
+	void Mirror(T* values, int rowSize) const
+	{
+		if (symmetry == Symmetry::Asymmetric)
+			return;
+
+		for (int y = mirror.y0; y < mirror.y1; y++)
+		{
+			T* dst = values + size_t(y) * rowSize;
+			const T* src = values + size_t(ky - y) * rowSize;
+
+			if (symmetry == Symmetry::RealAxis)
+			{
+				std::memcpy(dst + mirror.x0, src + mirror.x0, sizeof(T) * (mirror.x1 - mirror.x0));
+			}
+			else
+			{
+				for (int x = mirror.x0; x < mirror.x1; x++)
+					dst[x] = src[kx - x];
+			}
+		}
+	}
+};
+
+// Snap the mirror axis of one dimension to the pixel grid
+// Finds the mirror index k, so pixel p mirrors pixel k - p, and adjusts the world
+// coordinate of pixel 0 by at most a quarter of a pixel to make that exact
+// Returns false when the axis is too far from the view to be of any use
+inline bool SnapMirror(double& tl, double scale, double center, int size, int& k)
+{
+	double snapped = std::round(2.0 * (center - tl) / scale);
+	if (!(std::abs(snapped) <= 4.0 * size))
+		return false;
+
+	tl = center - snapped * scale / 2.0;
+	k = (int)snapped;
+	return true;
+}
+
+// Mirrored pixels are those beyond the middle, k / 2, whose mirror is still inside the view
+inline void MirrorRange(int k, int size, int& first, int& last)
+{
+	first = std::max(k / 2 + 1, std::max(0, k - size + 1));
+	last = std::min(size - 1, k);
+}
+
+inline RenderPlan PlanRender(int width, int height, double tlx, double tly, double brx, double bry, const SymmetryInfo& info, bool useSymmetry)
+{
+	RenderPlan plan;
+	plan.tlx = tlx;
+	plan.tly = tly;
+	plan.x_scale = (brx - tlx) / width;
+	plan.y_scale = (bry - tly) / height;
+
+	const RenderRect full = { 0, 0, width, height };
+
+	if (!useSymmetry || info.symmetry == Symmetry::Asymmetric)
+	{
+		plan.compute.push_back(full);
+		return plan;
+	}
+
+	// Both kinds of symmetry mirror rows, point symmetry also mirrors columns
+	double tlx_snapped = plan.tlx, tly_snapped = plan.tly;
+	bool usable = SnapMirror(tly_snapped, plan.y_scale, info.centeri, height, plan.ky);
+	if (usable && info.symmetry == Symmetry::Point)
+		usable = SnapMirror(tlx_snapped, plan.x_scale, info.centerr, width, plan.kx);
+
+	int firstRow = 0, lastRow = -1;
+	int firstColumn = 0, lastColumn = width - 1;
+	if (usable)
+	{
+		MirrorRange(plan.ky, height, firstRow, lastRow);
+
+		// For point symmetry, the columns must mirror inside the view as well
+		if (info.symmetry == Symmetry::Point)
+		{
+			firstColumn = std::max(0, plan.kx - width + 1);
+			lastColumn = std::min(width - 1, plan.kx);
+		}
+	}
+
+	if (firstRow > lastRow || firstColumn > lastColumn)
+	{
+		// No overlap with the mirror image, just calculate it all
+		plan.compute.push_back(full);
+		return plan;
+	}
+
+	plan.tlx = tlx_snapped;
+	plan.tly = tly_snapped;
+	plan.symmetry = info.symmetry;
+	plan.mirror = { firstColumn, firstRow, lastColumn + 1, lastRow + 1 };
+
+	// Everything else must be calculated: above, below and at the sides of the mirror
+	RenderRect parts[] =
+	{
+		{ 0, 0, width, firstRow },
+		{ 0, lastRow + 1, width, height },
+		{ 0, firstRow, firstColumn, lastRow + 1 },
+		{ lastColumn + 1, firstRow, width, lastRow + 1 },
+	};
+	for (const auto& r : parts)
+	{
+		if (!r.IsEmpty())
+			plan.compute.push_back(r);
+	}
+
+	return plan;
+}
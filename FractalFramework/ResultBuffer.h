@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "IterativeCompute.h"
+
+// How inside points are shown, corresponding to the ComputePoint* variants
+enum class InteriorMode
+{
+	Plain,			// ComputePoint
+	Loop,			// ComputePointWithLoop
+	Convergence,	// ComputePointWithConvergence
+	Index			// ComputePointWithIndex
+};
+
+// Per pixel results, one array per channel (structure of arrays)
+// Only the requested channels are allocated
+class ResultBuffer
+{
+public:
+	std::vector<int> count;
+	std::vector<float> magnitude2;
+	std::vector<int> period;
+	std::vector<int> convergence;
+	std::vector<int> index;
+	std::vector<float> smooth;
+	std::vector<float> distance;
+	std::vector<uint8_t> looped;
+
+	static unsigned ChannelsFor(InteriorMode mode)
+	{
+		switch (mode)
+		{
+		case InteriorMode::Loop:
+			return ChannelCount | ChannelLooped | ChannelPeriod;
+		case InteriorMode::Convergence:
+			return ChannelCount | ChannelLooped | ChannelConvergence;
+		case InteriorMode::Index:
+			return ChannelCount | ChannelLooped | ChannelIndex;
+		default:
+			return ChannelCount;
+		}
+	}
+
+	void Allocate(int width_, int height_, unsigned channels_)
+	{
+		width = width_;
+		height = height_;
+		channels = channels_ | ChannelCount;
+
+		const size_t size = size_t(width) * size_t(height);
+		auto allocate = [this, size] (auto& channel, unsigned bit)
+			{
+				channel.assign((channels & bit) ? size : 0, 0);
+			};
+		allocate(count, ChannelCount);
+		allocate(magnitude2, ChannelMagnitude2);
+		allocate(period, ChannelPeriod);
+		allocate(convergence, ChannelConvergence);
+		allocate(index, ChannelIndex);
+		allocate(smooth, ChannelSmooth);
+		allocate(distance, ChannelDistance);
+		allocate(looped, ChannelLooped);
+	}
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	unsigned getChannels() const { return channels; }
+	bool Has(unsigned channel) const { return (channels & channel) == channel; }
+
+	void Store(size_t i, const PointResult& r)
+	{
+		count[i] = r.count;
+		if (channels & ChannelMagnitude2)
+			magnitude2[i] = r.magnitude2;
+		if (channels & ChannelPeriod)
+			period[i] = r.period;
+		if (channels & ChannelConvergence)
+			convergence[i] = r.convergence;
+		if (channels & ChannelIndex)
+			index[i] = r.index;
+		if (channels & ChannelSmooth)
+			smooth[i] = r.smooth;
+		if (channels & ChannelDistance)
+			distance[i] = r.distance;
+		if (channels & ChannelLooped)
+			looped[i] = r.looped;
+	}
+
+	// The single value ComputePointCount() of the matching ComputePoint* variant would give
+	int Pack(size_t i, InteriorMode mode, int maxIterations) const
+	{
+		// Only the channel of the mode is read, the others need not be allocated
+		return PackValue(count[i], mode, maxIterations,
+						 [this, i] (unsigned channel)
+						 {
+							 return channel == ChannelLooped ? int(looped[i]) : channel == ChannelPeriod ? period[i] : channel == ChannelConvergence ? convergence[i] : index[i];
+						 });
+	}
+
+	// As Pack(), for a single result not in the buffer
+	static int PackResult(const PointResult& r, InteriorMode mode, int maxIterations)
+	{
+		return PackValue(r.count, mode, maxIterations,
+						 [&r] (unsigned channel)
+						 {
+							 return channel == ChannelLooped ? int(r.looped) : channel == ChannelPeriod ? r.period : channel == ChannelConvergence ? r.convergence : r.index;
+						 });
+	}
+
+	void PackAll(int* target, InteriorMode mode, int maxIterations) const
+	{
+		const int size = width * height;
+
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < size; i++)
+		{
+			target[i] = Pack(i, mode, maxIterations);
+		}
+	}
+
+	// Calls f(channel data pointer) for every allocated channel
+	template <typename F>
+	void ForEachChannel(F&& f)
+	{
+		auto apply = [&f] (auto& channel)
+			{
+				if (!channel.empty())
+					f(channel.data());
+			};
+		apply(count);
+		apply(magnitude2);
+		apply(period);
+		apply(convergence);
+		apply(index);
+		apply(smooth);
+		apply(distance);
+		apply(looped);
+	}
+
+private:
+	// The count, or for inside points the limit plus the value of the interior channel of the mode,
+	// asked from interior(channel) only when needed
+	// Points with a loop are inside for the modes checking loops, even if they escape later
+	template <typename Interior>
+	static int PackValue(int n, InteriorMode mode, int maxIterations, Interior interior)
+	{
+		if (n < maxIterations && (mode == InteriorMode::Plain || !interior(ChannelLooped)))
+			return n;
+
+		switch (mode)
+		{
+		case InteriorMode::Loop:
+			return maxIterations + interior(ChannelPeriod);
+		case InteriorMode::Convergence:
+			return maxIterations + interior(ChannelConvergence);
+		case InteriorMode::Index:
+			return maxIterations + interior(ChannelIndex);
+		default:
+			return maxIterations;
+		}
+	}
+
+	int width = 0;
+	int height = 0;
+	unsigned channels = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "IColorizer.h"
 #include <cmath>
+#include <algorithm>
 
 struct ShiftingColorizer : public ColorizerDecorator
 {
@@ -26,5 +27,51 @@ struct ShiftingColorizer : public ColorizerDecorator
 		return pCore->ColorizePixel(effValue);
 	}
 
+	olc::Pixel ColorizePixel(float value) const override
+	{
+		float effValue = fmodf(value + shift, pCore->getScale());
+
+		return pCore->ColorizePixel(effValue);
+	}
+
+	// Shift the values a chunk at a time, and colorize the shifted chunk with the core
+	void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override
+	{
+		int shifted[chunkSize];
+		const float scale = pCore->getScale();
+		// For a whole number scale, the integer remainder is the same as fmodf
+		const int intScale = (int) scale;
+		const bool whole = scale == (float) intScale && intScale > 0;
+		for (size_t begin = 0; begin < n; begin += chunkSize)
+		{
+			const size_t count = std::min(n - begin, size_t(chunkSize));
+			if (whole)
+			{
+				for (size_t i = 0; i < count; i++)
+					shifted[i] = (values[begin + i] + shift) % intScale;
+			}
+			else
+			{
+				for (size_t i = 0; i < count; i++)
+					shifted[i] = (int) fmodf((float) (values[begin + i] + shift), scale);
+			}
+			pCore->ColorizeSpan(shifted, out + begin, count);
+		}
+	}
+
+	void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override
+	{
+		float shifted[chunkSize];
+		const float scale = pCore->getScale();
+		for (size_t begin = 0; begin < n; begin += chunkSize)
+		{
+			const size_t count = std::min(n - begin, size_t(chunkSize));
+			for (size_t i = 0; i < count; i++)
+				shifted[i] = fmodf(values[begin + i] + shift, scale);
+			pCore->ColorizeSpan(shifted, out + begin, count);
+		}
+	}
 
+private:
+	static const int chunkSize = 256;
 };
\ No newline at end of file
@@ -17,6 +17,38 @@ public:
 		}
 	}
 
+	olc::Pixel ColorizePixel(float value) const override
+	{
+		if (static_cast<int>(value) % 2 == 1)
+		{
+			return olc::WHITE;
+		}
+		else
+		{
+			return pCore->ColorizePixel(value);
+		}
+	}
+
+	// The core colors the whole span, then the odd values are painted white
+	void ColorizeSpan(const int* values, olc::Pixel* out, size_t n) const override
+	{
+		pCore->ColorizeSpan(values, out, n);
+		for (size_t i = 0; i < n; i++)
+		{
+			if (values[i] % 2 == 1)
+				out[i] = olc::WHITE;
+		}
+	}
+
+	void ColorizeSpan(const float* values, olc::Pixel* out, size_t n) const override
+	{
+		pCore->ColorizeSpan(values, out, n);
+		for (size_t i = 0; i < n; i++)
+		{
+			if (static_cast<int>(values[i]) % 2 == 1)
+				out[i] = olc::WHITE;
+		}
+	}
 
 private:
 
@@ -0,0 +1,446 @@
+#pragma once
+
+// Persistent, memory-mapped store of finished result buffers
+//
+// The file is append-only: a fixed header, a fixed size index and then the
+// iteration arrays, one after the other. Lookups hand out a pointer straight
+// into the mapping, so reading a stored view costs no copy in the store itself.
+// Every entry carries a checksum, and entries failing it are dropped, so a
+// damaged file leads to a recalculation and never to garbage on the screen.
+// When the size cap is reached, the least recently used entries are evicted
+// by compacting the file in place.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <algorithm>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Everything that decides the content of a result buffer
+// Must be zero initialized before filling, as it is compared and hashed bytewise
+struct RenderKey
+{
+	char formula[16];		// IComputeState::Name()
+	char pointMethod[16];	// IComputePoint::Name()
+	int32_t julia;
+	int32_t width, height;
+	int32_t iterations;
+	int32_t symmetry;		// Mirrored views are snapped, and differ from the exact view by a part of a pixel
+	int32_t reserved;		// Zero, keeps the doubles aligned
+	double bailout;
+	double z0r, z0i;
+	double seedr, seedi;
+	double tlx, tly, brx, bry;
+
+	RenderKey() { std::memset(this, 0, sizeof(*this)); }
+
+	void setNames(const char* formula_, const char* pointMethod_)
+	{
+		std::strncpy(formula, formula_, sizeof(formula) - 1);
+		std::strncpy(pointMethod, pointMethod_, sizeof(pointMethod) - 1);
+	}
+
+	bool operator==(const RenderKey& other) const { return std::memcmp(this, &other, sizeof(*this)) == 0; }
+};
+
+static_assert(sizeof(RenderKey) == 32 + 6 * 4 + 9 * 8, "RenderKey must not contain padding");
+
+// Platform specific part, just a file mapped read/write into memory
+class MappedFile
+{
+public:
+	~MappedFile() { Close(); }
+
+	bool Open(const std::string& path)
+	{
+		Close();
+#if defined(_WIN32)
+		hFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(hFile, &fileSize);
+		size = (size_t)fileSize.QuadPart;
+#else
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			Close();
+			return false;
+		}
+		size = (size_t)st.st_size;
+#endif
+		return size == 0 || Map();
+	}
+
+	void Close()
+	{
+		Unmap();
+#if defined(_WIN32)
+		if (hFile != INVALID_HANDLE_VALUE)
+			CloseHandle(hFile);
+		hFile = INVALID_HANDLE_VALUE;
+#else
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+#endif
+		size = 0;
+	}
+
+	// All pointers into the mapping are invalid after this call
+	bool Resize(size_t newSize)
+	{
+		Unmap();
+#if defined(_WIN32)
+		LARGE_INTEGER pos;
+		pos.QuadPart = (LONGLONG)newSize;
+		if (!SetFilePointerEx(hFile, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(hFile))
+			return false;
+#else
+		if (ftruncate(fd, (off_t)newSize) != 0)
+			return false;
+#endif
+		size = newSize;
+		return size == 0 || Map();
+	}
+
+	uint8_t* Data() const { return data; }
+	size_t Size() const { return size; }
+
+private:
+	bool Map()
+	{
+#if defined(_WIN32)
+		hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+		if (!hMapping)
+			return false;
+		data = (uint8_t*)MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+		void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		data = p == MAP_FAILED ? nullptr : (uint8_t*)p;
+#endif
+		return data != nullptr;
+	}
+
+	void Unmap()
+	{
+#if defined(_WIN32)
+		if (data)
+			UnmapViewOfFile(data);
+		if (hMapping)
+			CloseHandle(hMapping);
+		hMapping = nullptr;
+#else
+		if (data)
+			munmap(data, size);
+#endif
+		data = nullptr;
+	}
+
+#if defined(_WIN32)
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+#else
+	int fd = -1;
+#endif
+	uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+class TileStore
+{
+public:
+	~TileStore() { Close(); }
+
+	bool Open(const std::string& path, size_t maxBytes_, uint32_t indexCapacity = 256)
+	{
+		std::unique_lock<std::shared_mutex> lock(mtx);
+
+		maxBytes = maxBytes_;
+		if (!file.Open(path))
+			return false;
+
+		bool valid = file.Size() >= sizeof(FileHeader)
+			&& std::memcmp(header()->magic, fileMagic, sizeof(fileMagic)) == 0
+			&& header()->version == fileVersion
+			&& file.Size() >= dataStart(header()->indexCapacity)
+			&& header()->dataEnd <= file.Size();
+
+		if (!valid)
+		{
+			// New or unusable file, start over with an empty index
+			if (!file.Resize(dataStart(indexCapacity)))
+			{
+				file.Close();
+				return false;
+			}
+			std::memset(file.Data(), 0, file.Size());
+			std::memcpy(header()->magic, fileMagic, sizeof(fileMagic));
+			header()->version = fileVersion;
+			header()->indexCapacity = indexCapacity;
+			header()->dataEnd = dataStart(indexCapacity);
+		}
+
+		lastUse.reset(new std::atomic<uint64_t>[header()->indexCapacity]);
+		for (uint32_t i = 0; i < header()->indexCapacity; i++)
+			lastUse[i] = index()[i].lastUse;
+		clock = header()->clock;
+
+		return true;
+	}
+
+	void Close()
+	{
+		std::unique_lock<std::shared_mutex> lock(mtx);
+
+		if (IsOpenUnlocked())
+			FlushUseCounts();
+		file.Close();
+	}
+
+	bool IsOpen() const
+	{
+		std::shared_lock<std::shared_mutex> lock(mtx);
+		return IsOpenUnlocked();
+	}
+
+	// Calls consumer(const int32_t* values, size_t count) with a pointer into the mapping
+	// The pointer is only valid during the call. Returns false if the key is not found
+	// or the stored data does not match its checksum
+	template <typename F>
+	bool Read(const RenderKey& key, F&& consumer)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(mtx);
+
+			if (!IsOpenUnlocked())
+				return false;
+
+			int i = Find(key);
+			if (i < 0)
+			{
+				misses++;
+				return false;
+			}
+
+			const IndexEntry& e = index()[i];
+			const int32_t* values = reinterpret_cast<const int32_t*>(file.Data() + e.offset);
+			if (Checksum(e.key, values, e.count) == e.checksum)
+			{
+				lastUse[i] = ++clock;
+				hits++;
+				consumer(values, (size_t)e.count);
+				return true;
+			}
+		}
+
+		// Corrupted, drop it so it is recomputed and stored again
+		misses++;
+		std::unique_lock<std::shared_mutex> lock(mtx);
+		int i = Find(key);
+		if (i >= 0)
+			index()[i].valid = 0;
+
+		return false;
+	}
+
+	bool Store(const RenderKey& key, const int32_t* values, size_t count)
+	{
+		std::unique_lock<std::shared_mutex> lock(mtx);
+
+		if (!IsOpenUnlocked())
+			return false;
+
+		const uint64_t bytes = count * sizeof(int32_t);
+		const uint64_t start = dataStart(header()->indexCapacity);
+		if (start + bytes > maxBytes)
+			return false;
+
+		int old = Find(key);
+		if (old >= 0)
+			index()[old].valid = 0;
+
+		int slot = FreeSlot();
+		if (slot < 0 || header()->dataEnd + bytes > maxBytes)
+		{
+			Compact(maxBytes - bytes);
+			if (!IsOpenUnlocked())
+				return false;
+			slot = FreeSlot();
+		}
+
+		uint64_t offset = header()->dataEnd;
+		if (offset + bytes > file.Size() && !file.Resize(offset + bytes))
+			return false;
+
+		std::memcpy(file.Data() + offset, values, bytes);
+
+		IndexEntry& e = index()[slot];
+		e.key = key;
+		e.offset = offset;
+		e.count = count;
+		e.checksum = Checksum(key, values, count);
+		lastUse[slot] = ++clock;
+		e.valid = 1;
+
+		header()->dataEnd = offset + bytes;
+		FlushUseCounts();
+
+		return true;
+	}
+
+	uint64_t getHits() const { return hits; }
+	uint64_t getMisses() const { return misses; }
+
+private:
+	static constexpr char fileMagic[8] = { 'F', 'F', 'T', 'I', 'L', 'E', 'S', '1' };
+	static constexpr uint32_t fileVersion = 2;
+
+	struct FileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t indexCapacity;
+		uint64_t dataEnd;
+		uint64_t clock;
+	};
+
+	struct IndexEntry
+	{
+		RenderKey key;
+		uint64_t offset;
+		uint64_t count;
+		uint64_t lastUse;
+		uint32_t checksum;
+		uint32_t valid;
+	};
+
+	static uint64_t dataStart(uint32_t indexCapacity)
+	{
+		return sizeof(FileHeader) + uint64_t(indexCapacity) * sizeof(IndexEntry);
+	}
+
+	FileHeader* header() const { return reinterpret_cast<FileHeader*>(file.Data()); }
+	IndexEntry* index() const { return reinterpret_cast<IndexEntry*>(file.Data() + sizeof(FileHeader)); }
+
+	bool IsOpenUnlocked() const { return file.Data() != nullptr && lastUse; }
+
+	// FNV-1a over key and values
+	static uint32_t Checksum(const RenderKey& key, const int32_t* values, uint64_t count)
+	{
+		uint32_t h = 2166136261u;
+		auto add = [&h] (const void* p, size_t n)
+			{
+				const uint8_t* b = static_cast<const uint8_t*>(p);
+				for (size_t i = 0; i < n; i++)
+					h = (h ^ b[i]) * 16777619u;
+			};
+		add(&key, sizeof(key));
+		add(values, size_t(count) * sizeof(int32_t));
+		return h;
+	}
+
+	int Find(const RenderKey& key) const
+	{
+		const uint64_t fileSize = file.Size();
+		for (uint32_t i = 0; i < header()->indexCapacity; i++)
+		{
+			const IndexEntry& e = index()[i];
+			if (e.valid && e.key == key && e.offset + e.count * sizeof(int32_t) <= fileSize)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	int FreeSlot() const
+	{
+		for (uint32_t i = 0; i < header()->indexCapacity; i++)
+		{
+			if (!index()[i].valid)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	void FlushUseCounts()
+	{
+		for (uint32_t i = 0; i < header()->indexCapacity; i++)
+			index()[i].lastUse = lastUse[i];
+		header()->clock = clock;
+	}
+
+	// Keep the most recently used entries that fit within budget bytes of file,
+	// and always leave at least one index slot free
+	void Compact(uint64_t budget)
+	{
+		const uint32_t capacity = header()->indexCapacity;
+
+		std::vector<uint32_t> live;
+		for (uint32_t i = 0; i < capacity; i++)
+		{
+			if (index()[i].valid)
+				live.push_back(i);
+		}
+		std::sort(live.begin(), live.end(), [this] (uint32_t a, uint32_t b) { return lastUse[a] > lastUse[b]; });
+
+		std::vector<uint32_t> keep;
+		uint64_t used = dataStart(capacity);
+		for (uint32_t i : live)
+		{
+			uint64_t bytes = index()[i].count * sizeof(int32_t);
+			if (used + bytes <= budget && keep.size() + 1 < capacity)
+			{
+				keep.push_back(i);
+				used += bytes;
+			}
+		}
+
+		// Invalidate everything first, so an interrupted compaction only loses entries
+		for (uint32_t i : live)
+			index()[i].valid = 0;
+
+		// Slide the kept entries down in file order
+		std::sort(keep.begin(), keep.end(), [this] (uint32_t a, uint32_t b) { return index()[a].offset < index()[b].offset; });
+		uint64_t dataEnd = dataStart(capacity);
+		for (uint32_t i : keep)
+		{
+			IndexEntry& e = index()[i];
+			uint64_t bytes = e.count * sizeof(int32_t);
+			std::memmove(file.Data() + dataEnd, file.Data() + e.offset, bytes);
+			e.offset = dataEnd;
+			e.valid = 1;
+			dataEnd += bytes;
+		}
+
+		header()->dataEnd = dataEnd;
+		file.Resize(dataEnd);
+	}
+
+	MappedFile file;
+	mutable std::shared_mutex mtx;
+	size_t maxBytes = 0;
+	std::unique_ptr<std::atomic<uint64_t>[]> lastUse;
+	std::atomic<uint64_t> clock{ 0 };
+	std::atomic<uint64_t> hits{ 0 };
+	std::atomic<uint64_t> misses{ 0 };
+};
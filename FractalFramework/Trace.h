@@ -0,0 +1,208 @@
+#pragma once
+
+// Timeline of the framework as Chrome trace events, for chrome://tracing or ui.perfetto.dev
+//
+// Build with FRACTAL_TRACE defined to record, otherwise TRACE_SCOPE and TRACE_INSTANT
+// compile to nothing. Every thread writes its spans into a ring buffer of its own, without
+// locks, the last traceCapacity events of each thread are kept. A lock is only taken when
+// a thread records its first event, when it ends and when the buffers are written out.
+// Events written while the buffers are written out may be missed or torn.
+//
+//	TRACE_SCOPE("colorize");	// Span from here to the end of the scope
+//	TRACE_INSTANT("cancel");	// A moment
+//	Trace::Write("trace.json");
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if defined(FRACTAL_TRACE)
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+class Trace
+{
+public:
+#if defined(FRACTAL_TRACE)
+	static const bool enabled = true;
+#else
+	static const bool enabled = false;
+#endif
+
+	// Writes the events of all threads, false when tracing is not built in, or the file can't be written
+	static bool Write(const std::string& path)
+	{
+#if defined(FRACTAL_TRACE)
+		FILE* file = std::fopen(path.c_str(), "w");
+		if (!file)
+			return false;
+
+		std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			for (const auto& buffer : registry.buffers)
+			{
+				const uint64_t count = buffer->count.load(std::memory_order_acquire);
+				const uint64_t begin = count > traceCapacity ? count - traceCapacity : 0;
+
+				for (uint64_t i = begin; i < count; i++)
+				{
+					const Event& e = buffer->events[i % traceCapacity];
+					if (e.duration == instant)
+						std::fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"fractal\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+									 first ? "" : ",\n", e.name, e.start / 1000.0, e.thread);
+					else
+						std::fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"fractal\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+									 first ? "" : ",\n", e.name, e.start / 1000.0, e.duration / 1000.0, e.thread);
+					first = false;
+				}
+			}
+		}
+		std::fprintf(file, "\n]}\n");
+
+		return std::fclose(file) == 0;
+#else
+		(void)path;
+		return false;
+#endif
+	}
+
+#if defined(FRACTAL_TRACE)
+	static const uint64_t traceCapacity = 1 << 16;	// Events per thread
+
+	static uint64_t Now()
+	{
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch()).count());
+	}
+
+	// name must be a string literal, or live as long
+	static void Record(const char* name, uint64_t start, uint64_t duration)
+	{
+		ThreadBuffer& holder = CurrentThread();
+		Buffer& buffer = *holder.buffer;
+		const uint64_t n = buffer.count.load(std::memory_order_relaxed);
+
+		Event& e = buffer.events[n % traceCapacity];
+		e.name = name;
+		e.start = start;
+		e.duration = duration;
+		e.thread = holder.thread;
+		buffer.count.store(n + 1, std::memory_order_release);
+	}
+
+	static void Instant(const char* name) { Record(name, Now(), instant); }
+
+private:
+	static const uint64_t instant = ~uint64_t(0);
+
+	struct Event
+	{
+		const char* name;
+		uint64_t start;		// Nanoseconds since the epoch
+		uint64_t duration;
+		uint32_t thread;
+	};
+
+	struct Buffer
+	{
+		std::unique_ptr<Event[]> events{ new Event[traceCapacity] };
+		std::atomic<uint64_t> count{ 0 };
+	};
+
+	// The buffers of ended threads are kept, with their events, and reused by new threads,
+	// the framework starts a thread for every calculation
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::shared_ptr<Buffer>> buffers;
+		std::vector<std::shared_ptr<Buffer>> unused;
+		uint32_t threads = 0;
+	};
+
+	struct ThreadBuffer
+	{
+		std::shared_ptr<Buffer> buffer;
+		uint32_t thread = 0;
+
+		ThreadBuffer()
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			thread = ++registry.threads;
+			if (!registry.unused.empty())
+			{
+				buffer = registry.unused.back();
+				registry.unused.pop_back();
+			}
+			else
+			{
+				buffer = std::make_shared<Buffer>();
+				registry.buffers.push_back(buffer);
+			}
+		}
+
+		~ThreadBuffer()
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.unused.push_back(buffer);
+		}
+	};
+
+	static Registry& GetRegistry()
+	{
+		// Never destroyed, threads may end after the static destructors
+		static Registry* registry = new Registry;
+		return *registry;
+	}
+
+	static ThreadBuffer& CurrentThread()
+	{
+		thread_local ThreadBuffer holder;
+		return holder;
+	}
+
+	static std::chrono::steady_clock::time_point Epoch()
+	{
+		static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+		return epoch;
+	}
+#endif
+};
+
+#if defined(FRACTAL_TRACE)
+
+// A span from construction to destruction
+class TraceScope
+{
+public:
+	TraceScope(const char* name_) : name(name_), start(Trace::Now()) {}
+	~TraceScope() { Trace::Record(name, start, Trace::Now() - start); }
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* name;
+	uint64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_INSTANT(name) Trace::Instant(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+
+#endif
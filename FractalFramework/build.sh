@@ -1 +1,3 @@
 g++ FractalFramework.cpp -Wall -fopenmp -std=c++17 -O3 -luser32 -lgdi32 -lopengl32 -lgdiplus -lShlwapi -ldwmapi -lstdc++fs -ltbb12 -o FractalFramework.exe
+g++ FractalRender.cpp -Wall -fopenmp -std=c++17 -O3 -lstdc++fs -ltbb12 -o FractalRender.exe
+g++ FractalBench.cpp -Wall -fopenmp -std=c++17 -O3 -ltbb12 -o FractalBench.exe
@@ -1 +1,3 @@
 clang++ -std=c++17 -O3 -fopenmp -lomp -ltbb -lpng -lX11 -lGL FractalFramework.cpp -o CLangFractalFramework
+clang++ -std=c++17 -O3 -fopenmp -lomp -ltbb FractalRender.cpp -o CLangFractalRender
+clang++ -std=c++17 -O3 -fopenmp -lomp -ltbb FractalBench.cpp -o CLangFractalBench
@@ -1 +1,3 @@
 g++  FractalFramework.cpp -fopenmp -lX11 -lGL -lpthread -lpng -lstdc++fs -ltbb -std=c++17 -O3 -o FractalFramework
+g++  FractalRender.cpp -fopenmp -lpthread -lstdc++fs -ltbb -std=c++17 -O3 -o FractalRender
+g++  FractalBench.cpp -fopenmp -lpthread -ltbb -std=c++17 -O3 -o FractalBench